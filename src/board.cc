@@ -91,7 +91,7 @@ bool Board::colorIsInCheck(Color color) const {
     return false;
   }
 
-  return _squareUnderAttack(getOppositeColor(color), kingSquare);
+  return squareUnderAttack(getOppositeColor(color), kingSquare);
 }
 
 int Board::getHalfmoveClock() const {
@@ -105,7 +105,7 @@ bool Board::whiteCanCastleKs() const {
 
   U64 passThroughSquares = (ONE << f1) | (ONE << g1);
   bool squaresOccupied = passThroughSquares & _occupied;
-  bool squaresAttacked = _squareUnderAttack(BLACK, f1) || _squareUnderAttack(BLACK, g1);
+  bool squaresAttacked = squareUnderAttack(BLACK, f1) || squareUnderAttack(BLACK, g1);
 
   return !colorIsInCheck(WHITE) && !squaresOccupied && !squaresAttacked;
 }
@@ -117,7 +117,7 @@ bool Board::whiteCanCastleQs() const {
 
   U64 inbetweenSquares = (ONE << c1) | (ONE << d1) | (ONE << b1);
   bool squaresOccupied = inbetweenSquares & _occupied;
-  bool squaresAttacked = _squareUnderAttack(BLACK, d1) || _squareUnderAttack(BLACK, c1);
+  bool squaresAttacked = squareUnderAttack(BLACK, d1) || squareUnderAttack(BLACK, c1);
 
   return !colorIsInCheck(WHITE) && !squaresOccupied && !squaresAttacked;
 }
@@ -129,7 +129,7 @@ bool Board::blackCanCastleKs() const {
 
   U64 passThroughSquares = (ONE << f8) | (ONE << g8);
   bool squaresOccupied = passThroughSquares & _occupied;
-  bool squaresAttacked = _squareUnderAttack(WHITE, f8) || _squareUnderAttack(WHITE, g8);
+  bool squaresAttacked = squareUnderAttack(WHITE, f8) || squareUnderAttack(WHITE, g8);
 
   return !colorIsInCheck(BLACK) && !squaresOccupied && !squaresAttacked;
 }
@@ -141,7 +141,7 @@ bool Board::blackCanCastleQs() const {
 
   U64 inbetweenSquares = (ONE << b8) | (ONE << c8) | (ONE << d8);
   bool squaresOccupied = inbetweenSquares & _occupied;
-  bool squaresAttacked = _squareUnderAttack(WHITE, c8) || _squareUnderAttack(WHITE, d8);
+  bool squaresAttacked = squareUnderAttack(WHITE, c8) || squareUnderAttack(WHITE, d8);
 
   return !colorIsInCheck(BLACK) && !squaresOccupied && !squaresAttacked;
 }
@@ -310,6 +310,8 @@ void Board::setToFen(std::string fenString) {
   // Halfmove clock
   fenStream >> _halfmoveClock;
 
+  _history.clear();
+
   _updateNonPieceBitBoards();
   _zKey = ZKey(*this);
   _pawnStructureZkey.setFromPawnStructure(*this);
@@ -363,6 +365,10 @@ void Board::_movePiece(Color color, PieceType pieceType, int from, int to) {
 
   _zKey.movePiece(color, pieceType, from, to);
   _pst.movePiece(color, pieceType, from, to);
+
+  if (pieceType == PAWN) {
+    _pawnStructureZkey.movePiece(color, PAWN, from, to);
+  }
 }
 
 void Board::_removePiece(Color color, PieceType pieceType, int squareIndex) {
@@ -375,6 +381,10 @@ void Board::_removePiece(Color color, PieceType pieceType, int squareIndex) {
 
   _zKey.flipPiece(color, pieceType, squareIndex);
   _pst.removePiece(color, pieceType, squareIndex);
+
+  if (pieceType == PAWN) {
+    _pawnStructureZkey.flipPiece(color, PAWN, squareIndex);
+  }
 }
 
 void Board::_addPiece(Color color, PieceType pieceType, int squareIndex) {
@@ -387,9 +397,23 @@ void Board::_addPiece(Color color, PieceType pieceType, int squareIndex) {
 
   _zKey.flipPiece(color, pieceType, squareIndex);
   _pst.addPiece(color, pieceType, squareIndex);
+
+  if (pieceType == PAWN) {
+    _pawnStructureZkey.flipPiece(color, PAWN, squareIndex);
+  }
 }
 
 void Board::doMove(Move move) {
+  // Save everything that can't be recomputed when undoing this move
+  State state;
+  state.move = move;
+  state.zKey = _zKey;
+  state.pawnStructureZkey = _pawnStructureZkey;
+  state.enPassant = _enPassant;
+  state.halfmoveClock = _halfmoveClock;
+  state.castlingRights = _castlingRights;
+  _history.push_back(state);
+
   // Clear En passant info after each move if it exists
   if (_enPassant) {
     _zKey.clearEnPassant();
@@ -475,16 +499,108 @@ void Board::doMove(Move move) {
     _updateCastlingRightsForMove(move);
   }
 
-  // Update pawn structure ZKey if this is a pawn move
-  if (move.getPieceType() == PAWN) {
-    _pawnStructureZkey.movePiece(_activePlayer, PAWN, move.getFrom(), move.getTo());
+  _zKey.flipActivePlayer();
+  _activePlayer = getInactivePlayer();
+}
+
+void Board::doNullMove() {
+  State state;
+  state.move = Move();
+  state.zKey = _zKey;
+  state.pawnStructureZkey = _pawnStructureZkey;
+  state.enPassant = _enPassant;
+  state.halfmoveClock = _halfmoveClock;
+  state.castlingRights = _castlingRights;
+  _history.push_back(state);
+
+  if (_enPassant) {
+    _zKey.clearEnPassant();
+    _enPassant = ZERO;
   }
 
+  _halfmoveClock++;
+
   _zKey.flipActivePlayer();
   _activePlayer = getInactivePlayer();
 }
 
-bool Board::_squareUnderAttack(Color color, int squareIndex) const {
+void Board::undoMove() {
+  const State &state = _history.back();
+  Move move = state.move;
+
+  // Undo moves as the player who made them
+  _activePlayer = getInactivePlayer();
+
+  unsigned int flags = move.getFlags();
+  if (flags & Move::NULL_MOVE) {
+    // Null moves don't move any pieces, only the state below needs restoring
+  } else if (!flags || (flags & Move::DOUBLE_PAWN_PUSH)) {
+    _movePiece(_activePlayer, move.getPieceType(), move.getTo(), move.getFrom());
+  } else if ((flags & Move::CAPTURE) && (flags & Move::PROMOTION)) { // Capture promotion special case
+    // Remove promoted piece
+    _removePiece(_activePlayer, move.getPromotionPieceType(), move.getTo());
+
+    // Add back promoting pawn
+    _addPiece(_activePlayer, PAWN, move.getFrom());
+
+    // Add back captured piece
+    _addPiece(getInactivePlayer(), move.getCapturedPieceType(), move.getTo());
+  } else if (flags & Move::CAPTURE) {
+    // Move capturing piece back
+    _movePiece(_activePlayer, move.getPieceType(), move.getTo(), move.getFrom());
+
+    // Add back captured piece
+    _addPiece(getInactivePlayer(), move.getCapturedPieceType(), move.getTo());
+  } else if (flags & Move::KSIDE_CASTLE) {
+    // Move the king back
+    _movePiece(_activePlayer, KING, move.getTo(), move.getFrom());
+
+    // Move the correct rook back
+    if (_activePlayer == WHITE) {
+      _movePiece(WHITE, ROOK, f1, h1);
+    } else {
+      _movePiece(BLACK, ROOK, f8, h8);
+    }
+  } else if (flags & Move::QSIDE_CASTLE) {
+    // Move the king back
+    _movePiece(_activePlayer, KING, move.getTo(), move.getFrom());
+
+    // Move the correct rook back
+    if (_activePlayer == WHITE) {
+      _movePiece(WHITE, ROOK, d1, a1);
+    } else {
+      _movePiece(BLACK, ROOK, d8, a8);
+    }
+  } else if (flags & Move::EN_PASSANT) {
+    // Move the capturing pawn back
+    _movePiece(_activePlayer, PAWN, move.getTo(), move.getFrom());
+
+    // Add back the captured pawn
+    if (_activePlayer == WHITE) {
+      _addPiece(BLACK, PAWN, move.getTo() - 8);
+    } else {
+      _addPiece(WHITE, PAWN, move.getTo() + 8);
+    }
+  } else if (flags & Move::PROMOTION) {
+    // Remove promoted piece
+    _removePiece(_activePlayer, move.getPromotionPieceType(), move.getTo());
+
+    // Add back promoting pawn
+    _addPiece(_activePlayer, PAWN, move.getFrom());
+  }
+
+  // Restore irreversible state (this also overwrites the incremental key
+  // updates made by the piece movements above)
+  _zKey = state.zKey;
+  _pawnStructureZkey = state.pawnStructureZkey;
+  _enPassant = state.enPassant;
+  _halfmoveClock = state.halfmoveClock;
+  _castlingRights = state.castlingRights;
+
+  _history.pop_back();
+}
+
+bool Board::squareUnderAttack(Color color, int squareIndex) const {
   // Check for pawn, knight and king attacks
   if (Attacks::getNonSlidingAttacks(PAWN, squareIndex, getOppositeColor(color)) & getPieces(color, PAWN)) return true;
   if (Attacks::getNonSlidingAttacks(KNIGHT, squareIndex) & getPieces(color, KNIGHT)) return true;
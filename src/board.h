@@ -6,6 +6,7 @@
 #include "zkey.h"
 #include "move.h"
 #include <string>
+#include <vector>
 
 class Move;
 
@@ -60,10 +61,30 @@ class Board {
   /**
    * @brief Performs the specified move on this board.
    *
+   * The state needed to take the move back again is pushed onto this board's
+   * state stack, so that the move can later be undone with undoMove().
+   *
    * @param move Move to perform on the board.
    */
   void doMove(Move);
 
+  /**
+   * @brief Passes the turn to the other player without moving a piece.
+   *
+   * The en passant square is cleared. Like doMove(), this pushes onto this
+   * board's state stack, and the null move is taken back with undoMove().
+   */
+  void doNullMove();
+
+  /**
+   * @brief Takes back the last move performed with doMove() or doNullMove().
+   *
+   * Must only be called if at least one move has been performed on this
+   * board since it was last set with setToFen() or setToStartPos(), or since
+   * it was copied (copies of a board do not share its state stack).
+   */
+  void undoMove();
+
   /**
    * @brief Returns true if white can castle kingside, false otherwise.
    *
@@ -124,6 +145,18 @@ class Board {
    */
   bool colorIsInCheck(Color) const;
 
+  /**
+   * @brief Determines if the given square is under attack by the given color.
+   *
+   * Returns true if the square (given as a little endian rank file map index)
+   * is under attack by the given color.
+   *
+   * @param  color        Color to check
+   * @param  squareIndex  Square to check (little endian rank file mapping)
+   * @return True if the square is under attack, false otherwise
+   */
+  bool squareUnderAttack(Color, int) const;
+
   /**
    * @brief Gets the number of halfmoves since the last capture or pawn move
    *
@@ -242,6 +275,65 @@ class Board {
   U64 getAttacksForSquare(PieceType, Color, int) const;
 
  private:
+  /**
+   * @brief Irreversible board state saved by doMove() so that undoMove() can
+   * restore it.
+   */
+  struct State {
+    /**
+     * @brief Move that was made (this includes the captured piece type, if any)
+     */
+    Move move;
+
+    /**
+     * @brief Zobrist key before the move was made
+     */
+    ZKey zKey;
+
+    /**
+     * @brief Pawn structure Zobrist key before the move was made
+     */
+    ZKey pawnStructureZkey;
+
+    /**
+     * @brief En passant target square before the move was made
+     */
+    U64 enPassant;
+
+    /**
+     * @brief Halfmove clock before the move was made
+     */
+    int halfmoveClock;
+
+    /**
+     * @brief Castling rights before the move was made
+     */
+    unsigned char castlingRights;
+  };
+
+  /**
+   * @brief Stack of State objects that is left empty when copied.
+   *
+   * Copying a Board does not copy its state stack, moves made on a board
+   * before it was copied can only be undone on the original board. This keeps
+   * copying a Board as cheap as it was before the state stack existed.
+   */
+  class StateStack : public std::vector<State> {
+   public:
+    StateStack() {}
+    StateStack(const StateStack &) : std::vector<State>() {}
+    StateStack &operator=(const StateStack &) {
+      clear();
+      return *this;
+    }
+  };
+
+  /**
+   * @brief Stack of states saved by doMove(), the last element corresponds to
+   * the last move made
+   */
+  StateStack _history;
+
   /**
    * @name Attack bitboard generation functions.
    * @brief Generate attack bitboards for specified squares.
@@ -319,18 +411,6 @@ class Board {
   unsigned char _castlingRights;
 
 
-  /**
-   * @brief Determines if the given square is under attack by the given color.
-   *
-   * Returns true if the square (given as a little endian rank file map index)
-   * is under attack by the given color.
-   *
-   * @param  color        Color to check
-   * @param  squareIndex  Square to check (little endian rank file mapping)
-   * @return True if the square is under attack, false otherwise
-   */
-  bool _squareUnderAttack(Color, int) const;
-
   /**
    * @brief Update the castling rights for the given move.
    *
@@ -64,9 +64,20 @@ const U64 ZERO = U64(0);
  */
 const U64 ONE = U64(1);
 
-/** @brief Positive infinity to be used during search (eg. as a return value for winning) */
+/** @brief Positive infinity to be used during search (eg. as an unbounded alpha-beta window) */
 const int INF = std::numeric_limits<int>::max();
 
+/**
+ * @brief Score of checkmating the opponent at the root.
+ *
+ * A checkmate delivered n plies from the root scores MATE - n (and -(MATE - n)
+ * for the side getting mated), so that shorter mates score better.
+ */
+const int MATE = 32000;
+
+/** @brief Scores of at least MATE_BOUND (or at most -MATE_BOUND) are mate scores */
+const int MATE_BOUND = MATE - 1000;
+
 /**
  * @enum Color
  * @brief Represents a color.
@@ -189,7 +189,7 @@ int Eval::evaluatePawnStructure(const Board &board, Color color, GamePhase phase
 }
 
 template<GamePhase phase>
-int Eval::evaluateForPhase(const Board &board, Color color) {
+int Eval::evaluateLazyForPhase(const Board &board, Color color) {
   int score = 0;
 
   Color otherColor = getOppositeColor(color);
@@ -209,6 +209,15 @@ int Eval::evaluateForPhase(const Board &board, Color color) {
   // Piece square tables
   score += board.getPSquareTable().getScore(phase, color) - board.getPSquareTable().getScore(phase, otherColor);
 
+  return score;
+}
+
+template<GamePhase phase>
+int Eval::evaluateForPhase(const Board &board, Color color) {
+  int score = evaluateLazyForPhase<phase>(board, color);
+
+  Color otherColor = getOppositeColor(color);
+
   // Mobility
   score += evaluateMobility(board, phase, color) - evaluateMobility(board, phase, otherColor);
 
@@ -251,3 +260,11 @@ int Eval::evaluate(const Board &board, Color color) {
   // Interpolate between opening/endgame scores depending on the phase
   return ((openingScore * (MAX_PHASE - phase)) + (endgameScore * phase)) / MAX_PHASE;
 }
+
+int Eval::evaluateLazy(const Board &board, Color color) {
+  int openingScore = evaluateLazyForPhase<OPENING>(board, color);
+  int endgameScore = evaluateLazyForPhase<ENDGAME>(board, color);
+  int phase = getPhase(board);
+
+  return ((openingScore * (MAX_PHASE - phase)) + (endgameScore * phase)) / MAX_PHASE;
+}
@@ -146,6 +146,19 @@ void init();
  */
 int evaluate(const Board &, Color);
 
+/**
+ * @brief Returns a quick estimate of the advantage of the given color in
+ * centipawns, considering only material and piece square tables
+ *
+ * This skips the more expensive positional terms of Eval::evaluate() and can
+ * be used when only a rough score is needed.
+ *
+ * @param board Board to evaluate
+ * @param color Color to evaluate advantage of
+ * @return Estimated advantage of the given color in centipawns
+ */
+int evaluateLazy(const Board &, Color);
+
 /**
  * @brief Returns a numeric representation of the given board's phase based
  * off remaining material
@@ -175,6 +188,20 @@ const int MAX_PHASE = 256;
 template<GamePhase phase>
 int evaluateForPhase(const Board &, Color);
 
+/**
+ * @brief Returns the advantage of the given color in centipawns considering
+ * only material and piece square tables, assuming the game is in the given
+ * phase
+ *
+ * @tparam phase Phase of game to evaluate for
+ * @param board Board to evaluate
+ * @param color Color to evaluate advantage of
+ * @return Material and piece square table advantage of the given color in
+ * centipawns, assuming the given game phase
+ */
+template<GamePhase phase>
+int evaluateLazyForPhase(const Board &, Color);
+
 /**
  * @brief Returns the value of the given PieceType used for evaluation
  * purposes in centipawns
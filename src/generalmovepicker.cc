@@ -1,55 +1,197 @@
 #include "movepicker.h"
 #include "generalmovepicker.h"
 #include "eval.h"
+#include "see.h"
+#include <algorithm>
 
-GeneralMovePicker::GeneralMovePicker(const OrderingInfo *orderingInfo, const Board *board, MoveList *moveList)
-    : MovePicker(moveList) {
+GeneralMovePicker::GeneralMovePicker(const OrderingInfo *orderingInfo, const Board *board, const SearchStack *ss)
+    : MovePicker(&_moveList) {
   _orderingInfo = orderingInfo;
-  _moves = moveList;
   _board = board;
+  _ss = ss;
+  _stage = HASH_MOVE;
+  _hasNext = false;
   _currHead = 0;
-  _scoreMoves();
+  _badCapturesStart = 0;
+  _quietsStart = 0;
 }
 
-void GeneralMovePicker::_scoreMoves() {
-  const TranspTableEntry *ttEntry = _orderingInfo->getTt()->getEntry(_board->getZKey());
-  Move pvMove;
-  if (ttEntry) {
-    pvMove = ttEntry->getBestMove();
+bool GeneralMovePicker::hasNext() {
+  if (!_hasNext) {
+    _findNext();
   }
+  return _hasNext;
+}
+
+Move GeneralMovePicker::getNext() {
+  _hasNext = false;
+  return _next;
+}
+
+void GeneralMovePicker::_findNext() {
+  while (_stage != DONE) {
+    switch (_stage) {
+      case HASH_MOVE: {
+        _stage = GEN_CAPTURES;
+
+        // The hash move may belong to another position with the same key bits.
+        // It is read only once, as other threads may overwrite the entry.
+        const TranspTableEntry *ttEntry = _orderingInfo->getTt()->getEntry(_board->getZKey());
+        Move hashMove = ttEntry ? ttEntry->getBestMove() : Move();
+        if (ttEntry && MoveGen::isLegal(*_board, hashMove)) {
+          _hashMove = hashMove;
+          _next = _hashMove;
+          _hasNext = true;
+          return;
+        }
+        break;
+      }
+      case GEN_CAPTURES:_genCaptures();
+        _stage = GOOD_CAPTURES;
+        break;
+      case GOOD_CAPTURES:
+        if (_currHead < _badCapturesStart) {
+          std::swap(_moveList.at(_currHead), _moveList.at(_bestIndex(_currHead, _badCapturesStart)));
+          Move move = _moveList.at(_currHead++);
+          if (!_alreadyPicked(move)) {
+            _next = move;
+            _hasNext = true;
+            return;
+          }
+        } else {
+          _stage = KILLER1;
+        }
+        break;
+      case KILLER1:
+      case KILLER2: {
+        bool first = _stage == KILLER1;
+        _stage = first ? KILLER2 : COUNTER_MOVE;
+
+        // Killers come from sibling positions, so they must be quiet and legal here
+        Move killer = first ? _ss->killer1 : _ss->killer2;
+        if (!(killer.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT))
+            && !_alreadyPicked(killer)
+            && MoveGen::isLegal(*_board, killer)) {
+          (first ? _killer1 : _killer2) = killer;
+          _next = killer;
+          _hasNext = true;
+          return;
+        }
+        break;
+      }
+      case COUNTER_MOVE: {
+        _stage = GEN_QUIETS;
 
-  for (auto &move : *_moves) {
-    if (move == pvMove) {
-      move.setValue(INF);
-    } else if (move.getFlags() & Move::CAPTURE) {
-      move.setValue(CAPTURE_BONUS + _mvvLvaTable[move.getCapturedPieceType()][move.getPieceType()]);
+        // The counter move of the last move was played in other positions too
+        Move counterMove = _orderingInfo->getCounterMove(_board->getActivePlayer(), (_ss - 1)->currentMove);
+        if (!(counterMove.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT | Move::NULL_MOVE))
+            && !_alreadyPicked(counterMove)
+            && MoveGen::isLegal(*_board, counterMove)) {
+          _counterMove = counterMove;
+          _next = counterMove;
+          _hasNext = true;
+          return;
+        }
+        break;
+      }
+      case GEN_QUIETS:_genQuiets();
+        _currHead = _quietsStart;
+        _stage = QUIETS;
+        break;
+      case QUIETS:
+        if (_currHead < _moveList.size()) {
+          std::swap(_moveList.at(_currHead), _moveList.at(_bestIndex(_currHead, _moveList.size())));
+          Move move = _moveList.at(_currHead++);
+          if (!_alreadyPicked(move)) {
+            _next = move;
+            _hasNext = true;
+            return;
+          }
+        } else {
+          _currHead = _badCapturesStart;
+          _stage = BAD_CAPTURES;
+        }
+        break;
+      case BAD_CAPTURES:
+        if (_currHead < _quietsStart) {
+          std::swap(_moveList.at(_currHead), _moveList.at(_bestIndex(_currHead, _quietsStart)));
+          Move move = _moveList.at(_currHead++);
+          if (!_alreadyPicked(move)) {
+            _next = move;
+            _hasNext = true;
+            return;
+          }
+        } else {
+          _stage = DONE;
+        }
+        break;
+      case DONE:break;
+    }
+  }
+}
+
+void GeneralMovePicker::_genCaptures() {
+  MoveGen::genLegalMoves(*_board, MoveGen::CAPTURES, _moveList);
+
+  Color color = _board->getActivePlayer();
+  for (auto &move : _moveList) {
+    if (move.getFlags() & Move::CAPTURE) {
+      move.setValue(CAPTURE_BONUS + MVV_LVA_WEIGHT * _mvvLvaTable[move.getCapturedPieceType()][move.getPieceType()]
+                        + _orderingInfo->getCaptureHistory(color, move) / CAPTURE_HISTORY_DIVISOR);
     } else if (move.getFlags() & Move::PROMOTION) {
       move.setValue(PROMOTION_BONUS + Eval::getMaterialValue(move.getPromotionPieceType()));
-    } else if (move == _orderingInfo->getKiller1(_orderingInfo->getPly())) {
-      move.setValue(KILLER1_BONUS);
-    } else if (move == _orderingInfo->getKiller2(_orderingInfo->getPly())) {
-      move.setValue(KILLER2_BONUS);
-    } else { // Quiet
-      move.setValue(QUIET_BONUS + _orderingInfo->getHistory(_board->getActivePlayer(), move.getFrom(), move.getTo()));
+    } else { // En passant
+      move.setValue(CAPTURE_BONUS + MVV_LVA_WEIGHT * _mvvLvaTable[PAWN][PAWN]
+                        + _orderingInfo->getCaptureHistory(color, move) / CAPTURE_HISTORY_DIVISOR);
     }
   }
+
+  Move *badCaptures = std::partition(_moveList.begin(), _moveList.end(), [this](Move move) {
+    return _isGoodCapture(move);
+  });
+
+  _currHead = 0;
+  _badCapturesStart = badCaptures - _moveList.begin();
+  _quietsStart = _moveList.size();
 }
 
-bool GeneralMovePicker::hasNext() const {
-  return _currHead < _moves->size();
+void GeneralMovePicker::_genQuiets() {
+  MoveGen::genLegalMoves(*_board, MoveGen::QUIETS, _moveList);
+
+  Color color = _board->getActivePlayer();
+  for (size_t i = _quietsStart; i < _moveList.size(); i++) {
+    Move &move = _moveList.at(i);
+    move.setValue(QUIET_BONUS + _orderingInfo->getHistory(color, move.getFrom(), move.getTo())
+                      + (_ss - 1)->getContinuationHistory(1, move)
+                      + (_ss - 2)->getContinuationHistory(2, move));
+  }
 }
 
-Move GeneralMovePicker::getNext() {
-  size_t bestIndex;
-  int bestScore = -INF;
+size_t GeneralMovePicker::_bestIndex(size_t start, size_t end) {
+  size_t bestIndex = start;
+  int bestScore = _moveList.at(start).getValue();
 
-  for (size_t i = _currHead; i < _moves->size(); i++) {
-    if (_moves->at(i).getValue() > bestScore) {
-      bestScore = _moves->at(i).getValue();
+  for (size_t i = start + 1; i < end; i++) {
+    if (_moveList.at(i).getValue() > bestScore) {
+      bestScore = _moveList.at(i).getValue();
       bestIndex = i;
     }
   }
 
-  std::swap(_moves->at(_currHead), _moves->at(bestIndex));
-  return _moves->at(_currHead++);
-}
\ No newline at end of file
+  return bestIndex;
+}
+
+bool GeneralMovePicker::_isGoodCapture(Move move) const {
+  // Promotions and en passant captures are always good
+  if (!(move.getFlags() & Move::CAPTURE)) {
+    return true;
+  }
+
+  // Captures of pieces worth at least as much as the capturing piece can't lose material
+  return Eval::getMaterialValue(move.getCapturedPieceType()) >= Eval::getMaterialValue(move.getPieceType())
+      || See::evaluate(*_board, move) >= 0;
+}
+
+bool GeneralMovePicker::_alreadyPicked(Move move) const {
+  return move == _hashMove || move == _killer1 || move == _killer2 || move == _counterMove;
+}
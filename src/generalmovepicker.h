@@ -3,65 +3,201 @@
 
 #include "movepicker.h"
 #include "orderinginfo.h"
+#include "searchstack.h"
 #include "board.h"
 
 /**
  * @brief MovePicker that returns moves in an optimal order for negamax search.
- * 
+ *
  * Specifically, the GeneralMovePicker returns moves in the following order:
- * - Hash move from the transposition table (if it exists)
- * - Captures sorted by MVV/LVA
- * - Promotions
+ * - Hash move from the transposition table (if it exists and is legal)
+ * - Good captures sorted by MVV/LVA and capture history, and promotions
  * - Killer moves
- * - Quiet moves sorted by the history heuristic
+ * - Counter move of the last move
+ * - Quiet moves sorted by the history heuristic and continuation history
+ * - Bad captures sorted by MVV/LVA and capture history
+ *
+ * Moves are generated in stages, and each stage is only generated once it is
+ * reached. If the hash move causes a beta cutoff, no moves are generated at
+ * all.
+ *
+ * A capture is good if it does not lose material according to static
+ * exchange evaluation (see See::evaluate()).
  */
 class GeneralMovePicker : MovePicker {
  public:
   /**
-   * @brief Constructs a new GeneralMovePicker for the given OrderingInfo, Board and MoveList.
-   *  
+   * @brief Constructs a new GeneralMovePicker for the given OrderingInfo, Board and SearchStack entry.
+   *
    * @param orderingInfo OrderingInfo object containing information about the current state of the search
-   * @param board Current board state for all moves in the provided MoveList
-   * @param moveList Pointer to the MoveList to pick moves from
+   * @param board Board to pick moves for
+   * @param ss SearchStack entry of the node to pick moves for (the two entries before it must be valid too)
    */
-  GeneralMovePicker(const OrderingInfo *, const Board *, MoveList *);
+  GeneralMovePicker(const OrderingInfo *, const Board *, const SearchStack *);
 
-  bool hasNext() const override;
+  /**
+   * @brief Returns true if there are more moves to be picked.
+   *
+   * This may generate the next stage of moves.
+   *
+   * @return true if there are more moves to be picked, false otherwise
+   */
+  bool hasNext() override;
 
   /**
-   * @brief Returns the next best move in this GeneralMovePicker's MoveList for negamax search.
-   * 
+   * @brief Returns the next best move for negamax search.
+   *
    * Note that internally, this method performs a selection sort for one unpicked move of the
-   * highest value in this GeneralMovePicker's internal MoveList and thus has time complexity
-   * O(n) with respect to the size of the MoveList. Provided move ordering is close to optimal though,
-   * this should be the optimal behaviour as negamax search should hit a beta cutoff after a small
-   * number of good moves.
-   * 
-   * @return the next best move in this GeneralMovePicker's MoveList for negamax search.
+   * highest value in the current stage and thus has time complexity O(n) with respect to the
+   * size of the stage. Provided move ordering is close to optimal though, this should be the
+   * optimal behaviour as negamax search should hit a beta cutoff after a small number of good
+   * moves.
+   *
+   * hasNext() must have returned true before this method is called.
+   *
+   * @return the next best move for negamax search.
    */
   Move getNext() override;
 
  private:
   /**
-   * @brief Assigns a value to each move in this GeneralMovePicker's MoveList representing desirability
-   * in a negamax search.
+   * @enum Stage
+   * @brief Stages of move generation, in the order they are reached.
+   */
+  enum Stage {
+    HASH_MOVE, /**< Return the hash move */
+    GEN_CAPTURES, /**< Generate and score captures and promotions */
+    GOOD_CAPTURES, /**< Return good captures and promotions */
+    KILLER1, /**< Return the first killer move */
+    KILLER2, /**< Return the second killer move */
+    COUNTER_MOVE, /**< Return the counter move of the last move */
+    GEN_QUIETS, /**< Generate and score quiet moves */
+    QUIETS, /**< Return quiet moves */
+    BAD_CAPTURES, /**< Return bad captures */
+    DONE /**< No moves left */
+  };
+
+  /**
+   * @brief Advances through the stages until a move is found or all stages are done.
+   *
+   * If a move is found, it is stored in _next.
+   */
+  void _findNext();
+
+  /**
+   * @brief Generates and scores captures and promotions, moving good ones in front of bad ones.
+   */
+  void _genCaptures();
+
+  /**
+   * @brief Generates quiet moves after the captures in _moveList and scores them.
+   */
+  void _genQuiets();
+
+  /**
+   * @brief Returns the index of the highest valued move in _moveList in the range [start, end).
+   *
+   * @param start First index to search
+   * @param end One past the last index to search
+   * @return The index of the highest valued move in the given range
    */
-  void _scoreMoves();
+  size_t _bestIndex(size_t, size_t);
 
   /**
-   * @brief Position of the first unpicked move in this GeneralMovePicker's MoveList
+   * @brief Returns true if the given capture is good (see class description).
+   *
+   * @param move Capture or promotion to check
+   * @return true if the given capture is good, false otherwise
+   */
+  bool _isGoodCapture(Move) const;
+
+  /**
+   * @brief Returns true if the given move has already been returned by an earlier stage.
+   *
+   * @param move Move to check
+   * @return true if the given move has already been returned, false otherwise
+   */
+  bool _alreadyPicked(Move) const;
+
+  /**
+   * @name Capture ordering weights
+   * @brief Captures are valued by MVV_LVA_WEIGHT times their MVV/LVA value
+   * plus their capture history divided by CAPTURE_HISTORY_DIVISOR.
+   *
+   * Capture history may reorder the attackers of a victim, but not victims.
+   * @{
+   */
+  static const int MVV_LVA_WEIGHT = 32;
+  static const int CAPTURE_HISTORY_DIVISOR = 256;
+  /**@}*/
+
+  /**
+   * @brief Moves generated so far (captures followed by quiets)
+   */
+  MoveList _moveList;
+
+  /**
+   * @brief Current stage of move generation
+   */
+  Stage _stage;
+
+  /**
+   * @brief Next move to return, valid if _hasNext is true
+   */
+  Move _next;
+
+  /**
+   * @brief True if _next holds a move that has not yet been returned
+   */
+  bool _hasNext;
+
+  /**
+   * @brief Position of the first unpicked move in the current stage
    */
   size_t _currHead;
 
+  /**
+   * @brief Position of the first bad capture in _moveList
+   */
+  size_t _badCapturesStart;
+
+  /**
+   * @brief Position of the first quiet move in _moveList
+   */
+  size_t _quietsStart;
+
+  /**
+   * @brief Hash move, null if there is none or it is not legal
+   */
+  Move _hashMove;
+
+  /**
+   * @brief Killer moves returned in the killer stages
+   * @{
+   */
+  Move _killer1;
+  Move _killer2;
+  /**@}*/
+
+  /**
+   * @brief Counter move returned in the counter move stage
+   */
+  Move _counterMove;
+
   /**
    * @brief OrderingInfo object containing search related information used by this GeneralMovePicker
    */
   const OrderingInfo *_orderingInfo;
 
   /**
-   * @brief Board for all moves in the provided MoveList
+   * @brief Board to pick moves for
    */
   const Board *_board;
+
+  /**
+   * @brief SearchStack entry of the node to pick moves for
+   */
+  const SearchStack *_ss;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,6 +3,7 @@
 #include "movepicker.h"
 #include "eval.h"
 #include "rays.h"
+#include "search.h"
 
 int main() {
   Rays::init();
@@ -11,6 +12,7 @@ int main() {
   MovePicker::init();
   Attacks::init();
   Eval::init();
+  Search::init();
   Uci::init();
 
   Uci::start();
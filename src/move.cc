@@ -16,6 +16,15 @@ Move::Move(unsigned int from, unsigned int to, PieceType piece, unsigned int fla
   _value = 0;
 }
 
+Move::Move(unsigned int packed) {
+  _move = packed;
+  _value = 0;
+}
+
+unsigned int Move::getPacked() const {
+  return _move;
+}
+
 PieceType Move::getPieceType() const {
   return static_cast<PieceType>(_move & 0x7);
 }
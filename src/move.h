@@ -2,7 +2,6 @@
 #define MOVE_H
 
 #include "defs.h"
-#include "board.h"
 #include <string>
 #include <vector>
 
@@ -26,6 +25,15 @@ class Move {
    */
   Move(unsigned int, unsigned int, PieceType, unsigned int= 0); // Non Null Move
 
+  /**
+   * @brief Construct a move from its packed representation (as returned by getPacked()).
+   *
+   * The value of the constructed move is set to 0.
+   *
+   * @param packed Packed representation of the move
+   */
+  explicit Move(unsigned int);
+
   /**
    * @enum Flag
    * @brief Flags that indicate special moves.
@@ -109,6 +117,16 @@ class Move {
    */
   void setValue(int);
 
+  /**
+   * @brief Returns the packed integer representation of this move.
+   *
+   * The returned value contains everything about this move except for its
+   * value and can be turned back into a Move with Move::Move(unsigned int).
+   *
+   * @return The packed integer representation of this move
+   */
+  unsigned int getPacked() const;
+
   /**
    * @brief Compare moves
    *
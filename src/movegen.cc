@@ -1,71 +1,244 @@
 #include "movegen.h"
+#include "attacks.h"
 #include "eval.h"
+#include <algorithm>
 
 MoveGen::MoveGen(const Board &board) {
   setBoard(board);
 }
 
-MoveGen::MoveGen() {
-  setBoard(Board());
-}
+MoveGen::MoveGen() : _board(nullptr), _pseudoLegalGenerated(true) {}
 
 void MoveGen::setBoard(const Board &board) {
-  _moves = MoveList();
-  _legalMoves = MoveList();
+  _board = &board;
+  _moves.clear();
+  _legalMoves.clear();
+  _pseudoLegalGenerated = false;
+  _genLegalMoves(board, ALL, ~ZERO, &_legalMoves);
+}
+
+void MoveGen::genLegalMoves(const Board &board, GenType type, MoveList &moves) {
+  MoveGen movegen;
+  movegen._genLegalMoves(board, type, ~ZERO, &moves);
+}
+
+bool MoveGen::isLegal(const Board &board, Move move) {
+  if (move.getFlags() & Move::NULL_MOVE) {
+    return false;
+  }
+
+  // Generate the legal moves of the piece on the move's from square only
+  MoveList moves;
+  MoveGen movegen;
+  movegen._genLegalMoves(board, ALL, ONE << move.getFrom(), &moves);
+
+  return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+void MoveGen::_genLegalMoves(const Board &board, GenType type, U64 fromMask, MoveList *moves) {
+  _genLegal = true;
+  _genCaptures = type == ALL || type == CAPTURES || type == EVASIONS;
+  _genQuiets = type != CAPTURES;
+  _fromMask = fromMask;
+  _setLegalityMasks(board);
+
+  size_t start = moves->size();
+  _list = moves;
   _genMoves(board);
+
+  // Keep only the quiet moves that give check
+  if (type == QUIET_CHECKS) {
+    Move *end = std::remove_if(moves->begin() + start, moves->end(), [this, &board](Move move) {
+      return !_givesCheck(board, move);
+    });
+    moves->resize(end - moves->begin());
+  }
+}
+
+bool MoveGen::_givesCheck(const Board &board, Move move) const {
+  Color us = board.getActivePlayer();
+  Color them = board.getInactivePlayer();
+
+  U64 theirKing = board.getPieces(them, KING);
+  if (!theirKing) {
+    return false;
+  }
+  int theirKingSquare = _bitscanForward(theirKing);
+
+  PieceType pieceType = move.getPieceType();
+  int from = move.getFrom();
+  int to = move.getTo();
+  U64 occupied = (board.getOccupied() ^ (ONE << from)) | (ONE << to);
+  U64 moved = ONE << from;
+
+  // When castling, the rook is the only piece that can give direct check
+  if (move.getFlags() & (Move::KSIDE_CASTLE | Move::QSIDE_CASTLE)) {
+    bool kingside = move.getFlags() & Move::KSIDE_CASTLE;
+    int rookFrom = kingside ? to + 1 : to - 2;
+    int rookTo = kingside ? to - 1 : to + 1;
+
+    occupied = (occupied ^ (ONE << rookFrom)) | (ONE << rookTo);
+    moved |= ONE << rookFrom;
+    pieceType = ROOK;
+    to = rookTo;
+  }
+
+  // Direct checks
+  U64 attacks = ZERO;
+  switch (pieceType) {
+    case PAWN:
+    case KNIGHT: attacks = Attacks::getNonSlidingAttacks(pieceType, to, us);
+      break;
+    case BISHOP:
+    case ROOK:
+    case QUEEN: attacks = Attacks::getSlidingAttacks(pieceType, to, occupied);
+      break;
+    case KING: break;
+  }
+  if (attacks & theirKing) {
+    return true;
+  }
+
+  // Discovered checks by our sliders that didn't move
+  U64 bishopsQueens = (board.getPieces(us, BISHOP) | board.getPieces(us, QUEEN)) & ~moved;
+  U64 rooksQueens = (board.getPieces(us, ROOK) | board.getPieces(us, QUEEN)) & ~moved;
+
+  return (Attacks::getSlidingAttacks(BISHOP, theirKingSquare, occupied) & bishopsQueens)
+      || (Attacks::getSlidingAttacks(ROOK, theirKingSquare, occupied) & rooksQueens);
 }
 
-void MoveGen::_genLegalMoves(const Board &board) {
-  _legalMoves.reserve(_moves.size());
-  for (auto move : _moves) {
-    Board tempBoard = board;
-    tempBoard.doMove(move);
+void MoveGen::_setLegalityMasks(const Board &board) {
+  Color us = board.getActivePlayer();
+  Color them = board.getInactivePlayer();
+
+  _kingSquare = _bitscanForward(board.getPieces(us, KING));
+  _targetMask = ~ZERO;
+  _pinned = ZERO;
 
-    // Skip adding this move if it results in moving into check
-    if (!tempBoard.colorIsInCheck(tempBoard.getInactivePlayer())) {
-      _legalMoves.push_back(move);
+  // Don't choke in testing scenarios where there is no king
+  if (_kingSquare == -1) {
+    return;
+  }
+
+  U64 occupied = board.getOccupied();
+  U64 theirBishopsQueens = board.getPieces(them, BISHOP) | board.getPieces(them, QUEEN);
+  U64 theirRooksQueens = board.getPieces(them, ROOK) | board.getPieces(them, QUEEN);
+
+  U64 checkers = (Attacks::getNonSlidingAttacks(PAWN, _kingSquare, us) & board.getPieces(them, PAWN))
+      | (Attacks::getNonSlidingAttacks(KNIGHT, _kingSquare) & board.getPieces(them, KNIGHT))
+      | (Attacks::getSlidingAttacks(BISHOP, _kingSquare, occupied) & theirBishopsQueens)
+      | (Attacks::getSlidingAttacks(ROOK, _kingSquare, occupied) & theirRooksQueens);
+
+  if (_popCount(checkers) > 1) {
+    // Only the king can move when in double check
+    _targetMask = ZERO;
+  } else if (checkers) {
+    // Capture the checker or block it
+    _targetMask = checkers | Rays::getBetween(_kingSquare, _bitscanForward(checkers));
+  }
+
+  // Sliders that would attack the king if nothing was in the way pin the
+  // only piece between them and the king (if it is ours)
+  U64 snipers = (Attacks::getSlidingAttacks(BISHOP, _kingSquare, ZERO) & theirBishopsQueens)
+      | (Attacks::getSlidingAttacks(ROOK, _kingSquare, ZERO) & theirRooksQueens);
+  while (snipers) {
+    U64 blockers = Rays::getBetween(_kingSquare, _popLsb(snipers)) & occupied;
+    if (_popCount(blockers) == 1) {
+      _pinned |= blockers & board.getAllPieces(us);
     }
   }
 }
 
-MoveList MoveGen::getMoves() {
+bool MoveGen::_squareAttacked(const Board &board, int square, U64 occupied, U64 ignored) const {
+  Color us = board.getActivePlayer();
+  Color them = board.getInactivePlayer();
+
+  if (Attacks::getNonSlidingAttacks(PAWN, square, us) & board.getPieces(them, PAWN) & ~ignored) return true;
+  if (Attacks::getNonSlidingAttacks(KNIGHT, square) & board.getPieces(them, KNIGHT) & ~ignored) return true;
+  if (Attacks::getNonSlidingAttacks(KING, square) & board.getPieces(them, KING)) return true;
+
+  U64 bishopsQueens = (board.getPieces(them, BISHOP) | board.getPieces(them, QUEEN)) & ~ignored;
+  if (Attacks::getSlidingAttacks(BISHOP, square, occupied) & bishopsQueens) return true;
+
+  U64 rooksQueens = (board.getPieces(them, ROOK) | board.getPieces(them, QUEEN)) & ~ignored;
+  if (Attacks::getSlidingAttacks(ROOK, square, occupied) & rooksQueens) return true;
+
+  return false;
+}
+
+bool MoveGen::_enPassantIsLegal(const Board &board, int from, int to) const {
+  if (_kingSquare == -1) {
+    return true;
+  }
+
+  // Make the capture on a copy of the occupancy bitboard and see if the king
+  // is attacked afterwards (this handles both evading checks and pins along
+  // the rank shared by both pawns)
+  int capturedSquare = board.getActivePlayer() == WHITE ? to - 8 : to + 8;
+  U64 occupied = (board.getOccupied() ^ (ONE << from) ^ (ONE << capturedSquare)) | (ONE << to);
+
+  return !_squareAttacked(board, _kingSquare, occupied, ONE << capturedSquare);
+}
+
+MoveList &MoveGen::getMoves() {
+  if (!_pseudoLegalGenerated) {
+    _genLegal = false;
+    _genCaptures = true;
+    _genQuiets = true;
+    _fromMask = ~ZERO;
+    _targetMask = ~ZERO;
+    _pinned = ZERO;
+
+    _list = &_moves;
+    _genMoves(*_board);
+    _pseudoLegalGenerated = true;
+  }
+
   return _moves;
 }
 
-MoveList MoveGen::getLegalMoves() {
+MoveList &MoveGen::getLegalMoves() {
   return _legalMoves;
 }
 
 void MoveGen::_genMoves(const Board &board) {
-  _moves.reserve(MOVELIST_RESERVE_SIZE);
   switch (board.getActivePlayer()) {
     case WHITE: _genWhiteMoves(board);
       break;
     case BLACK: _genBlackMoves(board);
       break;
   }
-  _genLegalMoves(board);
 }
 
 void MoveGen::_genWhiteMoves(const Board &board) {
-  _genWhitePawnMoves(board);
-  _genWhiteRookMoves(board);
-  _genWhiteKnightMoves(board);
-  _genWhiteBishopMoves(board);
+  // Only the king can move when in double check
+  if (_targetMask) {
+    _genWhitePawnMoves(board);
+    _genWhiteRookMoves(board);
+    _genWhiteKnightMoves(board);
+    _genWhiteBishopMoves(board);
+    _genWhiteQueenMoves(board);
+  }
   _genWhiteKingMoves(board);
-  _genWhiteQueenMoves(board);
 }
 
 void MoveGen::_genBlackMoves(const Board &board) {
-  _genBlackPawnMoves(board);
-  _genBlackRookMoves(board);
-  _genBlackKnightMoves(board);
-  _genBlackBishopMoves(board);
+  // Only the king can move when in double check
+  if (_targetMask) {
+    _genBlackPawnMoves(board);
+    _genBlackRookMoves(board);
+    _genBlackKnightMoves(board);
+    _genBlackBishopMoves(board);
+    _genBlackQueenMoves(board);
+  }
   _genBlackKingMoves(board);
-  _genBlackQueenMoves(board);
 }
 
 void MoveGen::_genPawnPromotions(unsigned int from, unsigned int to, unsigned int flags, PieceType capturedPieceType) {
+  if (_breaksPin(from, to)) {
+    return;
+  }
+
   Move promotionBase = Move(from, to, PAWN, flags | Move::PROMOTION);
   if (flags & Move::CAPTURE) {
     promotionBase.setCapturedPieceType(capturedPieceType);
@@ -73,32 +246,35 @@ void MoveGen::_genPawnPromotions(unsigned int from, unsigned int to, unsigned in
 
   Move queenPromotion = promotionBase;
   queenPromotion.setPromotionPieceType(QUEEN);
-  _moves.push_back(queenPromotion);
+  _list->push_back(queenPromotion);
 
   Move rookPromotion = promotionBase;
   rookPromotion.setPromotionPieceType(ROOK);
-  _moves.push_back(rookPromotion);
+  _list->push_back(rookPromotion);
 
   Move bishopPromotion = promotionBase;
   bishopPromotion.setPromotionPieceType(BISHOP);
-  _moves.push_back(bishopPromotion);
+  _list->push_back(bishopPromotion);
 
   Move knightPromotion = promotionBase;
   knightPromotion.setPromotionPieceType(KNIGHT);
-  _moves.push_back(knightPromotion);
+  _list->push_back(knightPromotion);
 }
 
 void MoveGen::_genWhitePawnSingleMoves(const Board &board) {
-  U64 movedPawns = board.getPieces(WHITE, PAWN) << 8;
-  movedPawns &= board.getNotOccupied();
+  U64 movedPawns = (board.getPieces(WHITE, PAWN) & _fromMask) << 8;
+  movedPawns &= board.getNotOccupied() & _targetMask;
 
-  U64 promotions = movedPawns & RANK_8;
-  movedPawns &= ~RANK_8;
+  // Promotions are generated with captures, other pushes with quiets
+  U64 promotions = _genCaptures ? movedPawns & RANK_8 : ZERO;
+  movedPawns &= _genQuiets ? ~RANK_8 : ZERO;
 
   // Generate single non promotion moves
   while (movedPawns) {
     int to = _popLsb(movedPawns);
-    _moves.push_back(Move(to - 8, to, PAWN));
+    if (_breaksPin(to - 8, to)) continue;
+
+    _list->push_back(Move(to - 8, to, PAWN));
   }
 
   // Generate promotions
@@ -109,31 +285,34 @@ void MoveGen::_genWhitePawnSingleMoves(const Board &board) {
 }
 
 void MoveGen::_genWhitePawnDoubleMoves(const Board &board) {
-  U64 singlePushes = (board.getPieces(WHITE, PAWN) << 8) & board.getNotOccupied();
-  U64 doublePushes = (singlePushes << 8) & board.getNotOccupied() & RANK_4;
+  U64 singlePushes = ((board.getPieces(WHITE, PAWN) & _fromMask) << 8) & board.getNotOccupied();
+  U64 doublePushes = (singlePushes << 8) & board.getNotOccupied() & RANK_4 & _targetMask;
 
   while (doublePushes) {
     int to = _popLsb(doublePushes);
-    _moves.push_back(Move(to - 16, to, PAWN, Move::DOUBLE_PAWN_PUSH));
+    if (_breaksPin(to - 16, to)) continue;
+
+    _list->push_back(Move(to - 16, to, PAWN, Move::DOUBLE_PAWN_PUSH));
   }
 }
 
 void MoveGen::_genWhitePawnLeftAttacks(const Board &board) {
-  U64 leftRegularAttacks = (board.getPieces(WHITE, PAWN) << 7) & board.getAttackable(BLACK) & ~FILE_H;
+  U64 leftRegularAttacks = ((board.getPieces(WHITE, PAWN) & _fromMask) << 7) & board.getAttackable(BLACK) & _targetMask & ~FILE_H;
 
   U64 leftAttackPromotions = leftRegularAttacks & RANK_8;
   leftRegularAttacks &= ~RANK_8;
 
-  U64 leftEnPassant = (board.getPieces(WHITE, PAWN) << 7) & board.getEnPassant() & ~FILE_H;
+  U64 leftEnPassant = ((board.getPieces(WHITE, PAWN) & _fromMask) << 7) & board.getEnPassant() & ~FILE_H;
 
   // Add regular attacks (Not promotions or en passants)
   while (leftRegularAttacks) {
     int to = _popLsb(leftRegularAttacks);
+    if (_breaksPin(to - 7, to)) continue;
 
     Move move = Move(to - 7, to, PAWN, Move::CAPTURE);
     move.setCapturedPieceType(board.getPieceAtSquare(BLACK, to));
 
-    _moves.push_back(move);
+    _list->push_back(move);
   }
 
   // Add promotion attacks
@@ -146,26 +325,29 @@ void MoveGen::_genWhitePawnLeftAttacks(const Board &board) {
   // There can only be one en passant square at a time, so no need for loop
   if (leftEnPassant) {
     int to = _popLsb(leftEnPassant);
-    _moves.push_back(Move(to - 7, to, PAWN, Move::EN_PASSANT));
+    if (!_genLegal || _enPassantIsLegal(board, to - 7, to)) {
+      _list->push_back(Move(to - 7, to, PAWN, Move::EN_PASSANT));
+    }
   }
 }
 
 void MoveGen::_genWhitePawnRightAttacks(const Board &board) {
-  U64 rightRegularAttacks = (board.getPieces(WHITE, PAWN) << 9) & board.getAttackable(BLACK) & ~FILE_A;
+  U64 rightRegularAttacks = ((board.getPieces(WHITE, PAWN) & _fromMask) << 9) & board.getAttackable(BLACK) & _targetMask & ~FILE_A;
 
   U64 rightAttackPromotions = rightRegularAttacks & RANK_8;
   rightRegularAttacks &= ~RANK_8;
 
-  U64 rightEnPassant = (board.getPieces(WHITE, PAWN) << 9) & board.getEnPassant() & ~FILE_A;
+  U64 rightEnPassant = ((board.getPieces(WHITE, PAWN) & _fromMask) << 9) & board.getEnPassant() & ~FILE_A;
 
   // Add regular attacks (Not promotions or en passants)
   while (rightRegularAttacks) {
     int to = _popLsb(rightRegularAttacks);
+    if (_breaksPin(to - 9, to)) continue;
 
     Move move = Move(to - 9, to, PAWN, Move::CAPTURE);
     move.setCapturedPieceType(board.getPieceAtSquare(BLACK, to));
 
-    _moves.push_back(move);
+    _list->push_back(move);
   }
 
   // Add promotion attacks
@@ -178,21 +360,26 @@ void MoveGen::_genWhitePawnRightAttacks(const Board &board) {
   // There can only be one en passant square at a time, so no need for loop
   if (rightEnPassant) {
     int to = _popLsb(rightEnPassant);
-    _moves.push_back(Move(to - 9, to, PAWN, Move::EN_PASSANT));
+    if (!_genLegal || _enPassantIsLegal(board, to - 9, to)) {
+      _list->push_back(Move(to - 9, to, PAWN, Move::EN_PASSANT));
+    }
   }
 }
 
 void MoveGen::_genBlackPawnSingleMoves(const Board &board) {
-  U64 movedPawns = board.getPieces(BLACK, PAWN) >> 8;
-  movedPawns &= board.getNotOccupied();
+  U64 movedPawns = (board.getPieces(BLACK, PAWN) & _fromMask) >> 8;
+  movedPawns &= board.getNotOccupied() & _targetMask;
 
-  U64 promotions = movedPawns & RANK_1;
-  movedPawns &= ~RANK_1;
+  // Promotions are generated with captures, other pushes with quiets
+  U64 promotions = _genCaptures ? movedPawns & RANK_1 : ZERO;
+  movedPawns &= _genQuiets ? ~RANK_1 : ZERO;
 
   // Generate single non promotion moves'
   while (movedPawns) {
     int to = _popLsb(movedPawns);
-    _moves.push_back(Move(to + 8, to, PAWN));
+    if (_breaksPin(to + 8, to)) continue;
+
+    _list->push_back(Move(to + 8, to, PAWN));
   }
 
   // Generate promotions
@@ -203,31 +390,34 @@ void MoveGen::_genBlackPawnSingleMoves(const Board &board) {
 }
 
 void MoveGen::_genBlackPawnDoubleMoves(const Board &board) {
-  U64 singlePushes = (board.getPieces(BLACK, PAWN) >> 8) & board.getNotOccupied();
-  U64 doublePushes = (singlePushes >> 8) & board.getNotOccupied() & RANK_5;
+  U64 singlePushes = ((board.getPieces(BLACK, PAWN) & _fromMask) >> 8) & board.getNotOccupied();
+  U64 doublePushes = (singlePushes >> 8) & board.getNotOccupied() & RANK_5 & _targetMask;
 
   while (doublePushes) {
     int to = _popLsb(doublePushes);
-    _moves.push_back(Move(to + 16, to, PAWN, Move::DOUBLE_PAWN_PUSH));
+    if (_breaksPin(to + 16, to)) continue;
+
+    _list->push_back(Move(to + 16, to, PAWN, Move::DOUBLE_PAWN_PUSH));
   }
 }
 
 void MoveGen::_genBlackPawnLeftAttacks(const Board &board) {
-  U64 leftRegularAttacks = (board.getPieces(BLACK, PAWN) >> 9) & board.getAttackable(WHITE) & ~FILE_H;
+  U64 leftRegularAttacks = ((board.getPieces(BLACK, PAWN) & _fromMask) >> 9) & board.getAttackable(WHITE) & _targetMask & ~FILE_H;
 
   U64 leftAttackPromotions = leftRegularAttacks & RANK_1;
   leftRegularAttacks &= ~RANK_1;
 
-  U64 leftEnPassant = (board.getPieces(BLACK, PAWN) >> 9) & board.getEnPassant() & ~FILE_H;
+  U64 leftEnPassant = ((board.getPieces(BLACK, PAWN) & _fromMask) >> 9) & board.getEnPassant() & ~FILE_H;
 
   // Add regular attacks (Not promotions or en passants)
   while (leftRegularAttacks) {
     int to = _popLsb(leftRegularAttacks);
+    if (_breaksPin(to + 9, to)) continue;
 
     Move move = Move(to + 9, to, PAWN, Move::CAPTURE);
     move.setCapturedPieceType(board.getPieceAtSquare(WHITE, to));
 
-    _moves.push_back(move);
+    _list->push_back(move);
   }
 
   // Add promotion attacks
@@ -240,26 +430,29 @@ void MoveGen::_genBlackPawnLeftAttacks(const Board &board) {
   // There can only be one en passant square at a time, so no need for loop
   if (leftEnPassant) {
     int to = _popLsb(leftEnPassant);
-    _moves.push_back(Move(to + 9, to, PAWN, Move::EN_PASSANT));
+    if (!_genLegal || _enPassantIsLegal(board, to + 9, to)) {
+      _list->push_back(Move(to + 9, to, PAWN, Move::EN_PASSANT));
+    }
   }
 }
 
 void MoveGen::_genBlackPawnRightAttacks(const Board &board) {
-  U64 rightRegularAttacks = (board.getPieces(BLACK, PAWN) >> 7) & board.getAttackable(WHITE) & ~FILE_A;
+  U64 rightRegularAttacks = ((board.getPieces(BLACK, PAWN) & _fromMask) >> 7) & board.getAttackable(WHITE) & _targetMask & ~FILE_A;
 
   U64 rightAttackPromotions = rightRegularAttacks & RANK_1;
   rightRegularAttacks &= ~RANK_1;
 
-  U64 rightEnPassant = (board.getPieces(BLACK, PAWN) >> 7) & board.getEnPassant() & ~FILE_A;
+  U64 rightEnPassant = ((board.getPieces(BLACK, PAWN) & _fromMask) >> 7) & board.getEnPassant() & ~FILE_A;
 
   // Add regular attacks (Not promotions or en passants)
   while (rightRegularAttacks) {
     int to = _popLsb(rightRegularAttacks);
+    if (_breaksPin(to + 7, to)) continue;
 
     Move move = Move(to + 7, to, PAWN, Move::CAPTURE);
     move.setCapturedPieceType(board.getPieceAtSquare(WHITE, to));
 
-    _moves.push_back(move);
+    _list->push_back(move);
   }
 
   // Add promotion attacks
@@ -272,43 +465,57 @@ void MoveGen::_genBlackPawnRightAttacks(const Board &board) {
   // There can only be one en passant square at a time, so no need for loop
   if (rightEnPassant) {
     int to = _popLsb(rightEnPassant);
-    _moves.push_back(Move(to + 7, to, PAWN, Move::EN_PASSANT));
+    if (!_genLegal || _enPassantIsLegal(board, to + 7, to)) {
+      _list->push_back(Move(to + 7, to, PAWN, Move::EN_PASSANT));
+    }
   }
 }
 
 void MoveGen::_genWhitePawnMoves(const Board &board) {
   _genWhitePawnSingleMoves(board);
-  _genWhitePawnDoubleMoves(board);
-  _genWhitePawnLeftAttacks(board);
-  _genWhitePawnRightAttacks(board);
+  if (_genQuiets) {
+    _genWhitePawnDoubleMoves(board);
+  }
+  if (_genCaptures) {
+    _genWhitePawnLeftAttacks(board);
+    _genWhitePawnRightAttacks(board);
+  }
 }
 
 void MoveGen::_genBlackPawnMoves(const Board &board) {
   _genBlackPawnSingleMoves(board);
-  _genBlackPawnDoubleMoves(board);
-  _genBlackPawnLeftAttacks(board);
-  _genBlackPawnRightAttacks(board);
+  if (_genQuiets) {
+    _genBlackPawnDoubleMoves(board);
+  }
+  if (_genCaptures) {
+    _genBlackPawnLeftAttacks(board);
+    _genBlackPawnRightAttacks(board);
+  }
 }
 
 void MoveGen::_genWhiteKingMoves(const Board &board) {
-  _genKingMoves(board, board.getPieces(WHITE, KING), board.getAttackable(BLACK));
+  _genKingMoves(board, board.getPieces(WHITE, KING) & _fromMask, board.getAttackable(BLACK));
+
+  bool castle = _genQuiets && (_fromMask & (ONE << e1));
 
-  if (board.whiteCanCastleKs()) {
-    _moves.push_back(Move(e1, g1, KING, Move::KSIDE_CASTLE));
+  if (castle && board.whiteCanCastleKs()) {
+    _list->push_back(Move(e1, g1, KING, Move::KSIDE_CASTLE));
   }
-  if (board.whiteCanCastleQs()) {
-    _moves.push_back(Move(e1, c1, KING, Move::QSIDE_CASTLE));
+  if (castle && board.whiteCanCastleQs()) {
+    _list->push_back(Move(e1, c1, KING, Move::QSIDE_CASTLE));
   }
 }
 
 void MoveGen::_genBlackKingMoves(const Board &board) {
-  _genKingMoves(board, board.getPieces(BLACK, KING), board.getAttackable(WHITE));
+  _genKingMoves(board, board.getPieces(BLACK, KING) & _fromMask, board.getAttackable(WHITE));
+
+  bool castle = _genQuiets && (_fromMask & (ONE << e8));
 
-  if (board.blackCanCastleKs()) {
-    _moves.push_back(Move(e8, g8, KING, Move::KSIDE_CASTLE));
+  if (castle && board.blackCanCastleKs()) {
+    _list->push_back(Move(e8, g8, KING, Move::KSIDE_CASTLE));
   }
-  if (board.blackCanCastleQs()) {
-    _moves.push_back(Move(e8, c8, KING, Move::QSIDE_CASTLE));
+  if (castle && board.blackCanCastleQs()) {
+    _list->push_back(Move(e8, c8, KING, Move::QSIDE_CASTLE));
   }
 }
 
@@ -321,15 +528,28 @@ void MoveGen::_genKingMoves(const Board &board, U64 king, U64 attackable) {
 
   U64 moves = board.getAttacksForSquare(KING, board.getActivePlayer(), kingIndex);
 
+  // Remove squares that are attacked. The king is removed from the occupancy
+  // so that it can't step back along the line of a slider checking it.
+  if (_genLegal) {
+    U64 occupied = board.getOccupied() ^ king;
+    U64 targets = moves;
+    while (targets) {
+      int to = _popLsb(targets);
+      if (_squareAttacked(board, to, occupied, ONE << to)) {
+        moves &= ~(ONE << to);
+      }
+    }
+  }
+
   _addMoves(board, kingIndex, KING, moves, attackable);
 }
 
 void MoveGen::_genWhiteKnightMoves(const Board &board) {
-  _genKnightMoves(board, board.getPieces(WHITE, KNIGHT), board.getAttackable(BLACK));
+  _genKnightMoves(board, board.getPieces(WHITE, KNIGHT) & _fromMask, board.getAttackable(BLACK));
 }
 
 void MoveGen::_genBlackKnightMoves(const Board &board) {
-  _genKnightMoves(board, board.getPieces(BLACK, KNIGHT), board.getAttackable(WHITE));
+  _genKnightMoves(board, board.getPieces(BLACK, KNIGHT) & _fromMask, board.getAttackable(WHITE));
 }
 
 void MoveGen::_genKnightMoves(const Board &board, U64 knights, U64 attackable) {
@@ -343,11 +563,11 @@ void MoveGen::_genKnightMoves(const Board &board, U64 knights, U64 attackable) {
 }
 
 void MoveGen::_genWhiteBishopMoves(const Board &board) {
-  _genBishopMoves(board, board.getPieces(WHITE, BISHOP), board.getAttackable(BLACK));
+  _genBishopMoves(board, board.getPieces(WHITE, BISHOP) & _fromMask, board.getAttackable(BLACK));
 }
 
 void MoveGen::_genBlackBishopMoves(const Board &board) {
-  _genBishopMoves(board, board.getPieces(BLACK, BISHOP), board.getAttackable(WHITE));
+  _genBishopMoves(board, board.getPieces(BLACK, BISHOP) & _fromMask, board.getAttackable(WHITE));
 }
 
 void MoveGen::_genBishopMoves(const Board &board, U64 bishops, U64 attackable) {
@@ -361,11 +581,11 @@ void MoveGen::_genBishopMoves(const Board &board, U64 bishops, U64 attackable) {
 }
 
 void MoveGen::_genWhiteRookMoves(const Board &board) {
-  _genRookMoves(board, board.getPieces(WHITE, ROOK), board.getAttackable(BLACK));
+  _genRookMoves(board, board.getPieces(WHITE, ROOK) & _fromMask, board.getAttackable(BLACK));
 }
 
 void MoveGen::_genBlackRookMoves(const Board &board) {
-  _genRookMoves(board, board.getPieces(BLACK, ROOK), board.getAttackable(WHITE));
+  _genRookMoves(board, board.getPieces(BLACK, ROOK) & _fromMask, board.getAttackable(WHITE));
 }
 
 void MoveGen::_genRookMoves(const Board &board, U64 rooks, U64 attackable) {
@@ -379,11 +599,11 @@ void MoveGen::_genRookMoves(const Board &board, U64 rooks, U64 attackable) {
 }
 
 void MoveGen::_genWhiteQueenMoves(const Board &board) {
-  _genQueenMoves(board, board.getPieces(WHITE, QUEEN), board.getAttackable(BLACK));
+  _genQueenMoves(board, board.getPieces(WHITE, QUEEN) & _fromMask, board.getAttackable(BLACK));
 }
 
 void MoveGen::_genBlackQueenMoves(const Board &board) {
-  _genQueenMoves(board, board.getPieces(BLACK, QUEEN), board.getAttackable(WHITE));
+  _genQueenMoves(board, board.getPieces(BLACK, QUEEN) & _fromMask, board.getAttackable(WHITE));
 }
 
 void MoveGen::_genQueenMoves(const Board &board, U64 queens, U64 attackable) {
@@ -400,21 +620,29 @@ void MoveGen::_addMoves(const Board &board, int from, PieceType pieceType, U64 m
   // Ignore all moves/attacks to kings
   moves &= ~(board.getPieces(board.getInactivePlayer(), KING));
 
+  // Only allow moves that deal with checks and keep pinned pieces on their pin rays
+  if (pieceType != KING) {
+    moves &= _targetMask;
+    if (_pinned & (ONE << from)) {
+      moves &= Rays::getLine(_kingSquare, from);
+    }
+  }
+
   // Generate non attacks
-  U64 nonAttacks = moves & ~attackable;
+  U64 nonAttacks = _genQuiets ? moves & ~attackable : ZERO;
   while (nonAttacks) {
     int to = _popLsb(nonAttacks);
-    _moves.push_back(Move(from, to, pieceType));
+    _list->push_back(Move(from, to, pieceType));
   }
 
   // Generate attacks
-  U64 attacks = moves & attackable;
+  U64 attacks = _genCaptures ? moves & attackable : ZERO;
   while (attacks) {
     int to = _popLsb(attacks);
 
     Move move(from, to, pieceType, Move::CAPTURE);
     move.setCapturedPieceType(board.getPieceAtSquare(board.getInactivePlayer(), to));
 
-    _moves.push_back(move);
+    _list->push_back(move);
   }
 }
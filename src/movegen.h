@@ -3,17 +3,35 @@
 
 #include "board.h"
 #include "defs.h"
+#include "rays.h"
+#include "movelist.h"
 
-/**
- * @brief Vector of move objects
- */
-typedef std::vector<Move> MoveList;
 
 /**
- * @brief Pseudo-legal move generator.
+ * @brief Legal and pseudo-legal move generator.
+ *
+ * Legal moves are generated directly, without making any moves. The pieces
+ * giving check and the pieces pinned to the active player's king are found
+ * once per position. Moves of pieces other than the king are then restricted
+ * to squares that block or capture a single checker (no squares at all when
+ * in double check) and, for pinned pieces, to squares on the pin ray. King
+ * moves and en passant captures (which can uncover an attack along the rank
+ * of both pawns) are checked individually.
  */
 class MoveGen {
  public:
+  /**
+   * @enum GenType
+   * @brief Types of moves that can be generated with MoveGen::genLegalMoves().
+   */
+  enum GenType {
+    ALL, /**< All moves */
+    CAPTURES, /**< Captures (including en passant) and promotions */
+    QUIETS, /**< All moves that are not generated with CAPTURES */
+    EVASIONS, /**< All moves out of check (the active player must be in check) */
+    QUIET_CHECKS /**< Moves generated with QUIETS that give check */
+  };
+
   /**
    * @brief Constructs a new MoveGen and generates moves for the given board.
    *
@@ -22,7 +40,7 @@ class MoveGen {
   MoveGen(const Board &board);
 
   /**
-   * @brief Constructs a new MoveGen for an empty board.
+   * @brief Constructs a new MoveGen with no board set.
    */
   MoveGen();
 
@@ -34,22 +52,51 @@ class MoveGen {
   void setBoard(const Board &board);
 
   /**
-   * @brief Returns all pseudo-legal moves that have been generated for the current board.
+   * @brief Returns all pseudo-legal moves for the current board.
+   *
+   * Pseudo-legal moves are only generated on the first call to this method,
+   * so the board given to this MoveGen must not have been modified or
+   * destroyed in the meantime.
+   *
+   * @return A reference to a MoveList of all pseudo-legal moves for the
+   * current board (valid for as long as this MoveGen is)
+   */
+  MoveList &getMoves();
+
+  /**
+   * @brief Returns all legal moves that have been generated for the current board.
+   *
+   * @return A reference to a MoveList of all legal moves that have been
+   * generated for the current board (valid for as long as this MoveGen is)
+   */
+  MoveList &getLegalMoves();
+
+  /**
+   * @brief Generates all legal moves of the given type for the given board and
+   * adds them to the given MoveList.
    *
-   * @return A MoveList of all pseudo-legal moves that have been generated for the current board.
+   * @param board Board to generate moves for
+   * @param type  Type of moves to generate
+   * @param moves MoveList to add the generated moves to
    */
-  MoveList getMoves();
+  static void genLegalMoves(const Board &, GenType, MoveList &);
 
   /**
-   * @brief Returns the subset of pseudo-legal moves that are legal.
+   * @brief Returns true if the given move is legal on the given board.
+   *
+   * The move may come from anywhere (eg. the transposition table or killer
+   * moves found in other positions). Only the moves of the piece on the
+   * move's from square are generated to check it.
    *
-   * @return A MoveList of all legal moves that have been generated for the current board.
+   * @param board Board to check the move on
+   * @param move  Move to check
+   * @return true if the given move is legal on the given board, false otherwise
    */
-  MoveList getLegalMoves();
+  static bool isLegal(const Board &, Move);
 
  private:
   /**
-   * @brief A vector containing generated pseudo-legal moves
+   * @brief MoveList of pseudo-legal moves.
    */
   MoveList _moves;
 
@@ -59,28 +106,133 @@ class MoveGen {
   MoveList _legalMoves;
 
   /**
-   * @brief Size of _moves to pre-reserve before generating moves.
+   * @brief MoveList that generation functions currently add moves to (either
+   * _moves or _legalMoves)
+   */
+  MoveList *_list;
+
+  /**
+   * @brief Board that moves are being generated for (used to generate
+   * pseudo-legal moves on demand)
+   */
+  const Board *_board;
+
+  /**
+   * @brief True if pseudo-legal moves have been generated into _moves
+   */
+  bool _pseudoLegalGenerated;
+
+  /**
+   * @brief True if only legal moves are currently being generated
+   */
+  bool _genLegal;
+
+  /**
+   * @brief True if captures and promotions are currently being generated
+   */
+  bool _genCaptures;
+
+  /**
+   * @brief True if quiet moves are currently being generated
+   */
+  bool _genQuiets;
+
+  /**
+   * @brief Only pieces on these squares are currently having moves generated
+   */
+  U64 _fromMask;
+
+  /**
+   * @brief Square of the active player's king, or -1 if there is none
+   */
+  int _kingSquare;
+
+  /**
+   * @brief Squares that pieces other than the king may move to
    *
-   * At the current time 218 seems to be an upper bound on the maximum number
-   * of moves from any one position.
+   * When in check by a single piece this holds the checker and the squares
+   * between it and the king. When in double check it is empty. Otherwise it
+   * holds every square.
    */
-  static const int MOVELIST_RESERVE_SIZE = 218;
+  U64 _targetMask;
 
   /**
-   * @brief Generates pseudo-legal moves for the active player of the given board
+   * @brief Pieces of the active player that are pinned to its king
+   */
+  U64 _pinned;
+
+  /**
+   * @brief Generates moves for the active player of the given board
    *
-   * Generated pseudo-legal moves are stored in the _moves vector.
+   * Generated moves are added to *_list. If _genLegal is set,
+   * generated moves are restricted by _targetMask and _pinned and king and
+   * en passant moves are checked individually, so that only legal moves are
+   * generated. Otherwise all pseudo-legal moves are generated.
    *
    * @param board Board to generate moves for
    */
   void _genMoves(const Board &board);
 
   /**
-   * @brief Populates the _legalMoves vector with moves from _moves that are legal.
+   * @brief Generates legal moves for the given board into the given MoveList.
+   *
+   * @param board    Board to generate legal moves for.
+   * @param type     Type of moves to generate
+   * @param fromMask Only generate moves for pieces on these squares
+   * @param moves    MoveList to add the generated moves to
+   */
+  void _genLegalMoves(const Board &, GenType, U64, MoveList *);
+
+  /**
+   * @brief Returns true if the given quiet move gives check on the given board.
+   *
+   * Both direct checks and discovered checks are detected.
+   *
+   * @param board Board the move is to be made on
+   * @param move  Quiet move to check
+   * @return true if the given move gives check, false otherwise
+   */
+  bool _givesCheck(const Board &, Move) const;
+
+  /**
+   * @brief Sets _kingSquare, _targetMask and _pinned for the given board.
+   *
+   * @param board Board to find checkers and pinned pieces for
+   */
+  void _setLegalityMasks(const Board &board);
+
+  /**
+   * @brief Returns true if the given square is attacked by the inactive player.
+   *
+   * @param board    Board to check
+   * @param square   Square to check
+   * @param occupied Occupancy to use when calculating sliding piece attacks
+   * @param ignored  Pieces of the inactive player that should not be counted
+   * as attackers (eg. pieces that would be captured)
+   * @return true if the given square is attacked by the inactive player
+   */
+  bool _squareAttacked(const Board &board, int square, U64 occupied, U64 ignored) const;
+
+  /**
+   * @brief Returns true if moving the pinned piece on from to to would break its pin.
+   *
+   * @param from Square the piece is moving from
+   * @param to   Square the piece is moving to
+   * @return true if the move is illegal because the moving piece is pinned
+   */
+  bool _breaksPin(int from, int to) const {
+    return (_pinned & (ONE << from)) && !(Rays::getLine(_kingSquare, from) & (ONE << to));
+  }
+
+  /**
+   * @brief Returns true if the given en passant capture is legal.
    *
-   * @param board Board to check legality of moves with.
+   * @param board Board to check
+   * @param from  Square the capturing pawn is moving from
+   * @param to    Square the capturing pawn is moving to
+   * @return true if the en passant capture is legal
    */
-  void _genLegalMoves(const Board &board);
+  bool _enPassantIsLegal(const Board &board, int from, int to) const;
 
   /**
    * @brief Convenience function to generate pawn promotions.
@@ -177,7 +329,7 @@ class MoveGen {
    *
    * Given a board, a from square, a PieceType, a bitboard containing generated
    * moves and a bitboard containing attackable pieces, generate all possible Move
-   * objects, and add them to the vector of pseudo-legal moves.
+   * objects, and add them to *_list.
    *
    * @param board      Board to generate moves for
    * @param from       Originating square of moves
@@ -0,0 +1,143 @@
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include "move.h"
+#include <cstddef>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Move>::value, "Moves must be trivially copyable to be stored in a MoveList");
+
+/**
+ * @brief Fixed capacity list of moves.
+ *
+ * A MoveList holds up to MoveList::MAX_SIZE moves in storage that is part of
+ * the MoveList object itself, so a MoveList declared as a local variable
+ * never allocates memory on the heap. Its interface is a subset of
+ * std::vector's.
+ *
+ * Moves in the unused part of the list are left uninitialized, so creating a
+ * MoveList costs nothing no matter how large MAX_SIZE is.
+ */
+class MoveList {
+ public:
+  /**
+   * @brief Maximum number of moves a MoveList can hold.
+   *
+   * 218 is the largest known number of legal moves from any one position.
+   */
+  static const size_t MAX_SIZE = 256;
+
+  /**
+   * @brief Constructs a new empty MoveList.
+   */
+  MoveList() : _size(0) {}
+
+  /**
+   * @brief Constructs a new MoveList containing a copy of the moves in the given MoveList.
+   *
+   * Only the used part of the other list is copied.
+   *
+   * @param other MoveList to copy
+   */
+  MoveList(const MoveList &other) : _size(0) {
+    *this = other;
+  }
+
+  /**
+   * @brief Replaces the moves in this MoveList with a copy of the moves in the given MoveList.
+   *
+   * @param other MoveList to copy
+   * @return A reference to this MoveList
+   */
+  MoveList &operator=(const MoveList &other) {
+    _size = other._size;
+    for (size_t i = 0; i < _size; i++) {
+      _data()[i] = other._data()[i];
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Adds the given move to the end of this MoveList.
+   *
+   * @param move Move to add
+   */
+  void push_back(Move move) { _data()[_size++] = move; }
+
+  /**
+   * @brief Removes all moves from this MoveList.
+   */
+  void clear() { _size = 0; }
+
+  /**
+   * @brief Removes all moves after the first size moves from this MoveList.
+   *
+   * Unlike std::vector::resize(), this can only shrink the list.
+   *
+   * @param size Number of moves to keep
+   */
+  void resize(size_t size) { _size = size; }
+
+  /**
+   * @brief Returns the number of moves in this MoveList.
+   *
+   * @return The number of moves in this MoveList
+   */
+  size_t size() const { return _size; }
+
+  /**
+   * @brief Returns true if this MoveList contains no moves.
+   *
+   * @return true if this MoveList contains no moves, false otherwise
+   */
+  bool empty() const { return _size == 0; }
+
+  /**
+   * @name Element access
+   * @brief Return a reference to the move at the given index.
+   *
+   * Unlike std::vector::at(), at() does not check its index.
+   *
+   * @{
+   */
+  Move &at(size_t i) { return _data()[i]; }
+  const Move &at(size_t i) const { return _data()[i]; }
+  Move &operator[](size_t i) { return _data()[i]; }
+  const Move &operator[](size_t i) const { return _data()[i]; }
+  /**@}*/
+
+  /**
+   * @name Iterators
+   * @brief Return pointers to the first move and one past the last move.
+   *
+   * @{
+   */
+  Move *begin() { return _data(); }
+  Move *end() { return _data() + _size; }
+  const Move *begin() const { return _data(); }
+  const Move *end() const { return _data() + _size; }
+  /**@}*/
+
+ private:
+  /**
+   * @brief Uninitialized storage for the moves in this MoveList
+   */
+  std::aligned_storage<sizeof(Move), alignof(Move)>::type _moves[MAX_SIZE];
+
+  /**
+   * @brief Number of moves in this MoveList
+   */
+  size_t _size;
+
+  /**
+   * @name Storage access
+   * @brief Return a pointer to the first move in _moves.
+   *
+   * @{
+   */
+  Move *_data() { return reinterpret_cast<Move *>(_moves); }
+  const Move *_data() const { return reinterpret_cast<const Move *>(_moves); }
+  /**@}*/
+};
+
+#endif
@@ -31,9 +31,12 @@ class MovePicker {
   /**
    * @brief Returns true if there are more moves to be picked from this MovePicker's MoveList
    * 
+   * This method is not const as MovePickers that generate moves in stages may
+   * need to generate the next stage of moves to determine if there are any left.
+   * 
    * @return true if there are more moves to be picked from this MovePicker's MoveList, false otherwise.
    */
-  virtual bool hasNext() const = 0;
+  virtual bool hasNext() = 0;
 
   /**
    * @brief Initializes constants used in picking moves.
@@ -57,6 +60,7 @@ class MovePicker {
    * @brief Bonuses applied to specific move types.
    * @{
    */
+  static const int HASH_MOVE_BONUS = 5000;
   static const int CAPTURE_BONUS = 4000;
   static const int PROMOTION_BONUS = 3000;
   static const int KILLER1_BONUS = 2000;
@@ -1,4 +1,7 @@
 #include "option.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 
 std::map<std::string, Option> optionsMap;
 
@@ -26,6 +29,14 @@ Option::Option(int value, int min, int max, OnChange onChange) :
     _max(max),
     _onChange(onChange) {}
 
+Option::Option(OnChange onChange) :
+    _value(""),
+    _type("button"),
+    _defaultValue(""),
+    _min(0),
+    _max(0),
+    _onChange(onChange) {}
+
 Option::Option(bool value, OnChange onChange) :
     _value(value ? "true" : "false"),
     _type("check"),
@@ -54,7 +65,20 @@ int Option::getMax() const {
   return _max;
 }
 
-void Option::setValue(std::string value) {
+bool Option::setValue(std::string value) {
+  if (_type == "spin") {
+    // Exceptions are disabled, so parse without std::stoi and reject anything
+    // that isn't entirely a number
+    char *end;
+    errno = 0;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno == ERANGE) {
+      return false;
+    }
+    value = std::to_string(std::max(static_cast<long>(_min), std::min(number, static_cast<long>(_max))));
+  }
+
   _value = value;
   if (_onChange != nullptr) _onChange();
+  return true;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define OPTIONMANAGER_H
 
 #include <map>
+#include <string>
 
 /**
  * @brief Type of callback function for when an option is changed
@@ -47,6 +48,17 @@ class Option {
    */
   Option(const char *, OnChange= nullptr); // String
 
+  /**
+   * @brief Constructs a new UCI button option with the specified OnChange
+   * callback
+   *
+   * Button options have no value, the callback is called every time the
+   * button is pressed.
+   *
+   * @param onChange Pointer to function to be called when this button is pressed
+   */
+  Option(OnChange); // Button
+
   /**
    * @brief Gets the current value of this option
    * 
@@ -88,10 +100,14 @@ class Option {
 
   /**
    * @brief Sets the value of this option to the specified string
+   *
+   * Values of spin options must be integers, and are clamped to the option's
+   * minimum and maximum.
    * 
    * @param value The value to set this option to
+   * @return False if the value is invalid, in which case the option is left unchanged
    */
-  void setValue(std::string);
+  bool setValue(std::string);
 
  private:
   /**
@@ -102,7 +118,7 @@ class Option {
   /**
    * @brief Type of this option
    * 
-   * Currently, this can be one of "check", "spin" or "string"
+   * Currently, this can be one of "check", "spin", "string" or "button"
    */
   std::string _type;
 
@@ -1,45 +1,97 @@
 #include "orderinginfo.h"
+#include <cstdlib>
 #include <cstring>
 
 OrderingInfo::OrderingInfo(const TranspTable *tt) {
   _tt = tt;
-  _ply = 0;
   std::memset(_history, 0, sizeof(_history));
+  std::memset(_continuationHistory, 0, sizeof(_continuationHistory));
+  std::memset(_captureHistory, 0, sizeof(_captureHistory));
 }
 
 void OrderingInfo::incrementHistory(Color color, int from, int to, int depth) {
-  _history[color][from][to] += depth * depth;
+  _applyBonus(_history[color][from][to], _historyBonus(depth));
+}
+
+void OrderingInfo::decrementHistory(Color color, int from, int to, int depth) {
+  _applyBonus(_history[color][from][to], -_historyBonus(depth));
 }
 
 int OrderingInfo::getHistory(Color color, int from, int to) const {
   return _history[color][from][to];
 }
 
-void OrderingInfo::incrementPly() {
-  _ply++;
+void OrderingInfo::incrementContinuationHistory(Color color, int plies, Move previous, Move move, int depth) {
+  if (!(previous.getFlags() & Move::NULL_MOVE)) {
+    _applyBonus(_continuationHistoryEntry(color, plies, previous, move), _historyBonus(depth));
+  }
 }
 
-void OrderingInfo::deincrementPly() {
-  _ply--;
+void OrderingInfo::decrementContinuationHistory(Color color, int plies, Move previous, Move move, int depth) {
+  if (!(previous.getFlags() & Move::NULL_MOVE)) {
+    _applyBonus(_continuationHistoryEntry(color, plies, previous, move), -_historyBonus(depth));
+  }
 }
 
-int OrderingInfo::getPly() const {
-  return _ply;
+int OrderingInfo::getContinuationHistory(Color color, int plies, Move previous, Move move) const {
+  if (previous.getFlags() & Move::NULL_MOVE) {
+    return 0;
+  }
+  Color previousColor = plies == 1 ? getOppositeColor(color) : color;
+  return _continuationHistory[previousColor][previous.getPieceType()][previous.getTo()]
+                             [plies - 1][move.getPieceType()][move.getTo()];
 }
 
-const TranspTable *OrderingInfo::getTt() const {
-  return _tt;
+const OrderingInfo::ContinuationHistory *OrderingInfo::getContinuationHistoryTable(Color color, Move previous) const {
+  if (previous.getFlags() & Move::NULL_MOVE) {
+    return nullptr;
+  }
+  return &_continuationHistory[color][previous.getPieceType()][previous.getTo()];
+}
+
+int &OrderingInfo::_continuationHistoryEntry(Color color, int plies, Move previous, Move move) {
+  Color previousColor = plies == 1 ? getOppositeColor(color) : color;
+  return _continuationHistory[previousColor][previous.getPieceType()][previous.getTo()]
+                             [plies - 1][move.getPieceType()][move.getTo()];
+}
+
+void OrderingInfo::incrementCaptureHistory(Color color, Move move, int depth) {
+  PieceType captured = (move.getFlags() & Move::EN_PASSANT) ? PAWN : move.getCapturedPieceType();
+  _applyBonus(_captureHistory[color][move.getPieceType()][move.getTo()][captured], _historyBonus(depth));
+}
+
+void OrderingInfo::decrementCaptureHistory(Color color, Move move, int depth) {
+  PieceType captured = (move.getFlags() & Move::EN_PASSANT) ? PAWN : move.getCapturedPieceType();
+  _applyBonus(_captureHistory[color][move.getPieceType()][move.getTo()][captured], -_historyBonus(depth));
 }
 
-void OrderingInfo::updateKillers(int ply, Move move) {
-  _killer2[ply] = _killer1[ply];
-  _killer1[ply] = move;
+int OrderingInfo::getCaptureHistory(Color color, Move move) const {
+  PieceType captured = (move.getFlags() & Move::EN_PASSANT) ? PAWN : move.getCapturedPieceType();
+  return _captureHistory[color][move.getPieceType()][move.getTo()][captured];
 }
 
-Move OrderingInfo::getKiller1(int ply) const {
-  return _killer1[ply];
+void OrderingInfo::updateCounterMove(Color color, Move previous, Move move) {
+  if (!(previous.getFlags() & Move::NULL_MOVE)) {
+    _counterMoves[color][previous.getPieceType()][previous.getTo()] = move;
+  }
 }
 
-Move OrderingInfo::getKiller2(int ply) const {
-  return _killer2[ply];
-}
\ No newline at end of file
+Move OrderingInfo::getCounterMove(Color color, Move previous) const {
+  if (previous.getFlags() & Move::NULL_MOVE) {
+    return Move();
+  }
+  return _counterMoves[color][previous.getPieceType()][previous.getTo()];
+}
+
+int OrderingInfo::_historyBonus(int depth) {
+  int bonus = 32 * depth * depth;
+  return bonus > MAX_HISTORY_BONUS ? MAX_HISTORY_BONUS : bonus;
+}
+
+void OrderingInfo::_applyBonus(int &value, int bonus) {
+  value += bonus - value * std::abs(bonus) / MAX_HISTORY;
+}
+
+const TranspTable *OrderingInfo::getTt() const {
+  return _tt;
+}
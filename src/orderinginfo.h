@@ -13,32 +13,27 @@
 class OrderingInfo {
  public:
   /**
-   * @brief Construct a new OrderingInfo with the provided transposition table
-   * 
-   * @param tt Transposition table of search
+   * @brief Continuation history values following one previous move, indexed
+   * by [plies - 1][piece][to_square] (see getContinuationHistoryTable()). The
+   * color of the side making the move follows from the previous move's color
+   * and plies.
    */
-  OrderingInfo(const TranspTable *);
+  typedef int ContinuationHistory[2][6][64];
 
   /**
-   * @brief Increment the ply number of this search by one.
-   */
-  void incrementPly();
-
-  /**
-   * @brief Decrement the ply number of this search by one.
-   */
-  void deincrementPly();
-
-  /**
-   * @brief Get the ply number of this search.
+   * @brief Construct a new OrderingInfo with the provided transposition table
    * 
-   * @return The ply number of this search.
+   * @param tt Transposition table of search
    */
-  int getPly() const;
+  OrderingInfo(const TranspTable *);
 
   /**
    * @brief Increment the beta-cutoff history heuristic value of the board for 
    * the given color, from square, to square and depth.
+   *
+   * All history tables are updated with gravity, so that values stay within
+   * [-MAX_HISTORY, MAX_HISTORY] and approach the bounds more slowly as they
+   * get closer to them.
    * 
    * @param color Color to increment history for
    * @param from From square to increment history for
@@ -47,6 +42,18 @@ class OrderingInfo {
    */
   void incrementHistory(Color, int, int, int);
 
+  /**
+   * @brief Decrement the beta-cutoff history heuristic value for the given
+   * color, from square and to square of a move that failed to cause a cutoff
+   * at the given depth.
+   *
+   * @param color Color to decrement history for
+   * @param from From square to decrement history for
+   * @param to To square to decrement history for
+   * @param depth Depth of the node the move was searched at
+   */
+  void decrementHistory(Color, int, int, int);
+
   /**
    * @brief Get beta-cutoff history information for the given color, from square and
    * to square.
@@ -59,35 +66,123 @@ class OrderingInfo {
   int getHistory(Color, int, int) const;
 
   /**
-   * @brief Update the killer moves for the given ply with the given move.
-   * 
-   * @param ply Ply to update killer moves for
-   * @param move Move to update killer moves with
+   * @brief Increment the continuation history value of a quiet move that caused
+   * a beta cutoff at the given depth, following the given previous move.
+   *
+   * Nothing is done if the previous move is a null move.
+   *
+   * @param color Color of side making the move
+   * @param plies Number of plies between the previous move and the move (1 or 2)
+   * @param previous Move made the given number of plies before the move
+   * @param move Move to increment continuation history for
+   * @param depth Depth of the node the move was searched at
    */
-  void updateKillers(int, Move);
+  void incrementContinuationHistory(Color, int, Move, Move, int);
 
   /**
-   * @brief Get a pointer to the search's transposition table.
-   * 
-   * @return A pointer to this search's transposition table.
+   * @brief Decrement the continuation history value of a quiet move that failed
+   * to cause a beta cutoff at the given depth, following the given previous move.
+   *
+   * Nothing is done if the previous move is a null move.
+   *
+   * @param color Color of side making the move
+   * @param plies Number of plies between the previous move and the move (1 or 2)
+   * @param previous Move made the given number of plies before the move
+   * @param move Move to decrement continuation history for
+   * @param depth Depth of the node the move was searched at
    */
-  const TranspTable *getTt() const;
+  void decrementContinuationHistory(Color, int, Move, Move, int);
 
   /**
-   * @brief Get the first killer move for the given ply.
-   * 
-   * @param ply Ply to get killer move for
-   * @return First killer move at the given ply
+   * @brief Get the continuation history value of the given move following the
+   * given previous move.
+   *
+   * Continuation history is indexed by the color, piece type and to square
+   * of both moves.
+   *
+   * @param color Color of side making the move
+   * @param plies Number of plies between the previous move and the move (1 or 2)
+   * @param previous Move made the given number of plies before the move
+   * @param move Move to get continuation history for
+   * @return Continuation history value of the move, or 0 if the previous move is a null move
+   */
+  int getContinuationHistory(Color, int, Move, Move) const;
+
+  /**
+   * @brief Get the continuation history values of all moves following the
+   * given previous move.
+   *
+   * This lets the search look up the table once per move made, rather than
+   * once per continuation history lookup.
+   *
+   * @param color Color of side making the previous move
+   * @param previous Move to get continuation history values for
+   * @return A pointer to the continuation history values following the given move, or nullptr if it is a null move
+   */
+  const ContinuationHistory *getContinuationHistoryTable(Color, Move) const;
+
+  /**
+   * @brief Increment the capture history value of a capture that caused a beta
+   * cutoff at the given depth.
+   *
+   * @param color Color of side moving
+   * @param move Capture to increment capture history for
+   * @param depth Depth of the node the move was searched at
+   */
+  void incrementCaptureHistory(Color, Move, int);
+
+  /**
+   * @brief Decrement the capture history value of a capture that failed to
+   * cause a beta cutoff at the given depth.
+   *
+   * @param color Color of side moving
+   * @param move Capture to decrement capture history for
+   * @param depth Depth of the node the move was searched at
    */
-  Move getKiller1(int) const;
+  void decrementCaptureHistory(Color, Move, int);
 
   /**
-   * @brief Get the second killer move for the given ply.
+   * @brief Get the capture history value of the given capture.
+   *
+   * Capture history is indexed by color, moving piece type, to square and
+   * captured piece type.
+   *
+   * @param color Color of side moving
+   * @param move Capture (or en passant capture) to get capture history for
+   * @return Capture history value of the given capture
+   */
+  int getCaptureHistory(Color, Move) const;
+
+  /**
+   * @brief Set the counter move of the given previous move to the given quiet move
+   * that caused a beta cutoff in reply to it.
+   *
+   * Nothing is done if the previous move is a null move.
+   *
+   * @param color Color of side replying to the previous move
+   * @param previous Move that was replied to
+   * @param move Move that caused a beta cutoff in reply to the previous move
+   */
+  void updateCounterMove(Color, Move, Move);
+
+  /**
+   * @brief Get the counter move of the given previous move.
+   *
+   * Counter moves are indexed by color and the piece type and to square of
+   * the previous move.
+   *
+   * @param color Color of side replying to the previous move
+   * @param previous Move to get the counter move for
+   * @return The counter move of the given move, or a null move if there is none
+   */
+  Move getCounterMove(Color, Move) const;
+
+  /**
+   * @brief Get a pointer to the search's transposition table.
    * 
-   * @param ply Ply to get killer move for
-   * @return Move Second killer move at the given ply
+   * @return A pointer to this search's transposition table.
    */
-  Move getKiller2(int) const;
+  const TranspTable *getTt() const;
 
  private:
   /**
@@ -96,24 +191,65 @@ class OrderingInfo {
   const TranspTable *_tt;
 
   /**
-   * @brief Array of first killer moves by ply
+   * @brief Table of beta-cutoff history values indexed by [color][from_square][to_square]
    */
-  Move _killer1[50];
+  int _history[2][64][64];
 
   /**
-   * @brief Array of second killer moves by ply
+   * @brief Continuation history values indexed by
+   * [previous_color][previous_piece][previous_to_square][plies - 1][piece][to_square]
    */
-  Move _killer2[50];
+  ContinuationHistory _continuationHistory[2][6][64];
 
   /**
-   * @brief Current ply of search
+   * @brief Capture history values indexed by [color][piece][to_square][captured_piece]
    */
-  int _ply;
+  int _captureHistory[2][6][64][6];
 
   /**
-   * @brief Table of beta-cutoff history values indexed by [color][from_square][to_square]
+   * @brief Counter moves indexed by [color][previous_piece][previous_to_square]
    */
-  int _history[2][64][64];
+  Move _counterMoves[2][6][64];
+
+  /**
+   * @brief Bound on the absolute value of all history values.
+   */
+  static const int MAX_HISTORY = 16384;
+
+  /**
+   * @brief Bound on the bonus a single history update at any depth can give.
+   */
+  static const int MAX_HISTORY_BONUS = 1536;
+
+  /**
+   * @brief Returns the continuation history value of the given move following
+   * the given (non null) previous move.
+   *
+   * @param color Color of side making the move
+   * @param plies Number of plies between the previous move and the move (1 or 2)
+   * @param previous Move made the given number of plies before the move
+   * @param move Move to get continuation history for
+   * @return A reference to the continuation history value of the move
+   */
+  int &_continuationHistoryEntry(Color, int, Move, Move);
+
+  /**
+   * @brief Returns the history bonus for a move searched at the given depth.
+   *
+   * @param depth Depth of the node the move was searched at
+   * @return The history bonus for a move searched at the given depth
+   */
+  static int _historyBonus(int);
+
+  /**
+   * @brief Adds the given bonus (or penalty if negative) to the given history
+   * value, scaled down by how close the value already is to MAX_HISTORY in
+   * the direction of the bonus.
+   *
+   * @param value History value to update
+   * @param bonus Bonus to add
+   */
+  static void _applyBonus(int &, int);
 };
 
 #endif
\ No newline at end of file
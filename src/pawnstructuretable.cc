@@ -1,18 +1,42 @@
 #include "pawnstructuretable.h"
 #include "defs.h"
 #include "board.h"
-#include <unordered_map>
 
-std::unordered_map<U64, PawnStructureTable::PawnStructureEntry> _table;
+namespace {
+/**
+ * @brief A slot in the pawn structure table
+ */
+struct Slot {
+  /** @brief Full ZKey value of the pawn structure stored in this slot */
+  U64 key;
+
+  /** @brief True if an entry has been stored in this slot */
+  bool used;
+
+  /** @brief Entry stored in this slot */
+  PawnStructureTable::PawnStructureEntry entry;
+};
+
+// Each search thread keeps its own pawn structure table so no locking is needed
+thread_local Slot _table[PawnStructureTable::NUM_SLOTS];
+
+Slot *_getSlot(U64 key) {
+  return &_table[key & (PawnStructureTable::NUM_SLOTS - 1)];
+}
+}
 
 PawnStructureTable::PawnStructureEntry *PawnStructureTable::get(ZKey key) {
-  return &_table.at(key.getValue());
+  Slot *slot = _getSlot(key.getValue());
+  return (slot->used && slot->key == key.getValue()) ? &slot->entry : nullptr;
 }
 
 bool PawnStructureTable::exists(ZKey key) {
-  return _table.find(key.getValue()) != _table.end();
+  return get(key) != nullptr;
 }
 
 void PawnStructureTable::set(ZKey key, PawnStructureTable::PawnStructureEntry entry) {
-  _table.insert(std::make_pair(key.getValue(), entry));
+  Slot *slot = _getSlot(key.getValue());
+  slot->key = key.getValue();
+  slot->used = true;
+  slot->entry = entry;
 }
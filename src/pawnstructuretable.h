@@ -10,8 +10,17 @@
  * This is a hash table to store evaluation scores of pawn structures. As
  * pawn structure doesn't often change in a search, evaluation can be sped
  * up by storing old scores in a table.
+ *
+ * The table has a fixed number of slots (PawnStructureTable::NUM_SLOTS) that
+ * are indexed by the low bits of a ZKey and always replaced on collisions, so
+ * it never allocates memory. Each thread has its own table.
  */
 namespace PawnStructureTable {
+/**
+ * @brief Number of slots in each thread's pawn structure table (a power of 2)
+ */
+const int NUM_SLOTS = 16384;
+
 /**
  * @brief An entry in the pawn structure table
  */
@@ -1,50 +1,70 @@
 #include "movepicker.h"
 #include "qsearchmovepicker.h"
 #include "eval.h"
+#include "see.h"
+#include <algorithm>
 
-QSearchMovePicker::QSearchMovePicker(MoveList *moveList) : MovePicker(moveList) {
+QSearchMovePicker::QSearchMovePicker(const Board *board, Move hashMove, bool genChecks) : MovePicker(&_moveList) {
   _currHead = 0;
 
-  // Count captures
-  _numCaptures = 0;
-  for (auto move : *moveList) {
-    if (move.getFlags() & Move::CAPTURE) {
-      _numCaptures++;
-    }
+  // Every evasion must be considered when in check
+  if (board->colorIsInCheck(board->getActivePlayer())) {
+    MoveGen::genLegalMoves(*board, MoveGen::EVASIONS, _moveList);
+    _scoreMoves(hashMove);
+    return;
+  }
+
+  MoveGen::genLegalMoves(*board, MoveGen::CAPTURES, _moveList);
+  if (genChecks) {
+    MoveGen::genLegalMoves(*board, MoveGen::QUIET_CHECKS, _moveList);
   }
 
-  _scoreMoves();
+  // Prune captures and checks that lose material (captures of pieces worth at
+  // least as much as the capturing piece never do, so skip evaluating those).
+  // The hash move has been searched before and is kept regardless.
+  Move *end = std::remove_if(_moveList.begin(), _moveList.end(), [board, hashMove](Move move) {
+    bool capture = move.getFlags() & Move::CAPTURE;
+    bool quiet = !(move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT));
+    return !(move == hashMove)
+        && (quiet || (capture && Eval::getMaterialValue(move.getCapturedPieceType()) < Eval::getMaterialValue(move.getPieceType())))
+        && See::evaluate(*board, move) < 0;
+  });
+  _moveList.resize(end - _moveList.begin());
+
+  _scoreMoves(hashMove);
 }
 
-void QSearchMovePicker::_scoreMoves() {
+void QSearchMovePicker::_scoreMoves(Move hashMove) {
   for (auto &move : *_moves) {
-    if (move.getFlags() & Move::CAPTURE) {
+    if (move == hashMove) {
+      move.setValue(HASH_MOVE_BONUS);
+    } else if (move.getFlags() & Move::CAPTURE) {
       move.setValue(CAPTURE_BONUS + _mvvLvaTable[move.getCapturedPieceType()][move.getPieceType()]);
     } else if (move.getFlags() & Move::PROMOTION) {
       move.setValue(PROMOTION_BONUS + Eval::getMaterialValue(move.getPromotionPieceType()));
+    } else if (move.getFlags() & Move::EN_PASSANT) {
+      move.setValue(CAPTURE_BONUS + _mvvLvaTable[PAWN][PAWN]);
+    } else {
+      move.setValue(QUIET_BONUS);
     }
   }
 }
 
-bool QSearchMovePicker::hasNext() const {
-  return _currHead < _numCaptures;
+bool QSearchMovePicker::hasNext() {
+  return _currHead < _moves->size();
 }
 
 Move QSearchMovePicker::getNext() {
-  size_t bestIndex;
-  int bestScore = -INF;
-
-  for (size_t i = _currHead; i < _moves->size(); i++) {
-    Move currMove = _moves->at(i);
-    int currScore = _moves->at(i).getValue();
+  size_t bestIndex = _currHead;
+  int bestScore = _moves->at(_currHead).getValue();
 
-    // Disregard non captures and promotions
-    if ((currMove.getFlags() & (Move::CAPTURE | Move::PROMOTION)) && (currScore > bestScore)) {
-      bestScore = currScore;
+  for (size_t i = _currHead + 1; i < _moves->size(); i++) {
+    if (_moves->at(i).getValue() > bestScore) {
+      bestScore = _moves->at(i).getValue();
       bestIndex = i;
     }
   }
 
   std::swap(_moves->at(_currHead), _moves->at(bestIndex));
   return _moves->at(_currHead++);
-}
\ No newline at end of file
+}
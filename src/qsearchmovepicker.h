@@ -7,25 +7,33 @@
  * @brief MovePicker that returns moves in an optimal order for quiescense 
  * search
  * 
- * Specifically, the QSearchMovePicker returns only capture moves in MVV/LVA
- * order, followed by promotions by value of promotion piece, ignoring all
- * other moves.
+ * Specifically, the QSearchMovePicker generates only captures and promotions
+ * (and optionally quiet checks), and returns captures in MVV/LVA order,
+ * followed by promotions by value of promotion piece and then quiet checks.
+ * Captures and quiet checks that lose material according to static exchange
+ * evaluation are not returned at all. If a hash move is given and it is one of
+ * the generated moves, it is returned first.
+ *
+ * If the side to move is in check, all evasions are returned instead, with
+ * none of them pruned.
  */
 class QSearchMovePicker : MovePicker {
  public:
   /**
-   * @brief Constructs a new QSearchMovePicker for the given MoveList
+   * @brief Constructs a new QSearchMovePicker for the given Board
    * 
-   * @param moveList MoveList to pick moves from
+   * @param board Board to pick moves for
+   * @param hashMove Best move from the transposition table, if any
+   * @param genChecks True if quiet checks should be returned too
    */
-  QSearchMovePicker(MoveList *);
+  QSearchMovePicker(const Board *, Move= Move(), bool= false);
 
-  bool hasNext() const override;
+  bool hasNext() override;
 
   /**
   * @brief Returns the next best move in this QSearchMovePicker's MoveList for quiescense search.
   *
-  * Note that internally, this method performs a selection sort for one unpicked capture move of the
+  * Note that internally, this method performs a selection sort for one unpicked move of the
   * highest value in this QSearchMovePicker's internal MoveList and thus has time complexity
   * O(n) with respect to the size of the MoveList. Provided move ordering is close to optimal though,
   * this should be the optimal behaviour as quiescense search should hit a beta cutoff after a small
@@ -37,20 +45,22 @@ class QSearchMovePicker : MovePicker {
 
  private:
   /**
-   * @brief Assigns a value to each capture move in this QSearchMovePicker representing desirability
-   * according to MVV/LVA.
+   * @brief Assigns a value to each move in this QSearchMovePicker representing desirability
+   * according to MVV/LVA, with the hash move valued above all others and quiet moves below.
+   *
+   * @param hashMove Best move from the transposition table, if any
    */
-  void _scoreMoves();
+  void _scoreMoves(Move);
 
   /**
-   * @brief Head of the current sorted part of the MoveList
+   * @brief Captures and promotions generated for the board
    */
-  size_t _currHead;
+  MoveList _moveList;
 
   /**
-   * @brief Number of captures in this QSearchMovePicker's MoveList
+   * @brief Head of the current sorted part of the MoveList
    */
-  size_t _numCaptures;
+  size_t _currHead;
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "bitutils.h"
 
 U64 Rays::detail::_rays[8][64];
+U64 Rays::detail::_between[64][64];
+U64 Rays::detail::_lines[64][64];
 
 void Rays::init() {
   for (int square = 0; square < 64; square++) {
@@ -29,8 +31,39 @@ void Rays::init() {
     // South East
     detail::_rays[SOUTH_EAST][square] = _eastN(0x2040810204080ULL, _col(square)) >> ((7 - _row(square)) * 8);
   }
+
+  // Directions in the same order as the Dir enum, paired with their opposites
+  const Dir opposite[8] = {SOUTH, NORTH, WEST, EAST, SOUTH_WEST, SOUTH_EAST, NORTH_WEST, NORTH_EAST};
+
+  for (int square1 = 0; square1 < 64; square1++) {
+    for (int square2 = 0; square2 < 64; square2++) {
+      detail::_between[square1][square2] = ZERO;
+      detail::_lines[square1][square2] = ZERO;
+    }
+
+    for (int dir = NORTH; dir <= SOUTH_WEST; dir++) {
+      U64 ray = detail::_rays[dir][square1];
+      U64 line = ray | detail::_rays[opposite[dir]][square1] | (ONE << square1);
+
+      U64 squares = ray;
+      while (squares) {
+        int square2 = _popLsb(squares);
+
+        detail::_between[square1][square2] = ray & ~detail::_rays[dir][square2] & ~(ONE << square2);
+        detail::_lines[square1][square2] = line;
+      }
+    }
+  }
 }
 
 U64 Rays::getRay(Dir dir, int square) {
   return detail::_rays[dir][square];
 }
+
+U64 Rays::getBetween(int square1, int square2) {
+  return detail::_between[square1][square2];
+}
+
+U64 Rays::getLine(int square1, int square2) {
+  return detail::_lines[square1][square2];
+}
@@ -7,7 +7,9 @@
  * @brief Namespace containg fast ray generation functions
  *
  * This namespace contains an init() function, which initializes a table of
- * 8*64 ray bitboards for each square and cardinal/intercardinal direction.
+ * 8*64 ray bitboards for each square and cardinal/intercardinal direction, as
+ * well as tables of the squares between and the lines through each pair of
+ * squares.
  *
  * In time intensive scenarios Rays::getRay() can then be used to get ray
  * bitboards when needed (eg. as masks for evaluation purposes).
@@ -19,6 +21,20 @@ namespace detail {
  * @brief Internal table of precalculated ray bitboards indexed by [Dir][square]
  */
 extern U64 _rays[8][64];
+
+/**
+ * @brief Internal table of bitboards of the squares strictly between two
+ * squares indexed by [square1][square2] (empty if the squares don't share a
+ * rank, file or diagonal)
+ */
+extern U64 _between[64][64];
+
+/**
+ * @brief Internal table of bitboards of the full line through two squares
+ * indexed by [square1][square2] (empty if the squares don't share a rank,
+ * file or diagonal)
+ */
+extern U64 _lines[64][64];
 };
 
 /**
@@ -49,6 +65,32 @@ void init();
  * @return A bitboard containing the given ray in the given direction
  */
 U64 getRay(Dir, int);
+
+/**
+ * @brief Gets a bitboard containing all squares strictly between the two
+ * given squares.
+ *
+ * If the squares do not share a rank, file or diagonal, an empty bitboard is
+ * returned.
+ *
+ * @param square1 First square (in little endian rank file mapping form)
+ * @param square2 Second square (in little endian rank file mapping form)
+ * @return A bitboard containing all squares strictly between square1 and square2
+ */
+U64 getBetween(int, int);
+
+/**
+ * @brief Gets a bitboard containing the entire line (edge to edge) through the
+ * two given squares.
+ *
+ * If the squares do not share a rank, file or diagonal, an empty bitboard is
+ * returned.
+ *
+ * @param square1 First square (in little endian rank file mapping form)
+ * @param square2 Second square (in little endian rank file mapping form)
+ * @return A bitboard containing the line through square1 and square2
+ */
+U64 getLine(int, int);
 };
 
 #endif
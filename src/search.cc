@@ -4,19 +4,50 @@
 #include "movepicker.h"
 #include "generalmovepicker.h"
 #include "qsearchmovepicker.h"
+#include "see.h"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <thread>
+
+const int Search::SKIP_SIZE[SKIP_TABLE_SIZE] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int Search::SKIP_PHASE[SKIP_TABLE_SIZE] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+const int Search::RAZOR_MARGIN[RAZOR_MAX_DEPTH + 1] = {0, 300, 500};
+const int Search::LMP_MOVE_COUNT[LMP_MAX_DEPTH + 1] = {0, 4, 7, 12};
+
+int Search::_lmrTable[64][64];
+
+void Search::init() {
+  for (int depth = 0; depth < 64; depth++) {
+    for (int moveNumber = 0; moveNumber < 64; moveNumber++) {
+      if (depth == 0 || moveNumber == 0) {
+        _lmrTable[depth][moveNumber] = 0;
+      } else {
+        _lmrTable[depth][moveNumber] = static_cast<int>(0.75 + std::log(depth) * std::log(moveNumber) / 2.25);
+      }
+    }
+  }
+}
 
-Search::Search(const Board &board, Limits limits, std::vector<ZKey> positionHistory, bool logUci) :
-    _positionHistory(positionHistory),
-    _orderingInfo(OrderingInfo(&_tt)),
+Search::Search(const Board &board,
+               Limits limits,
+               std::vector<ZKey> positionHistory,
+               TranspTable *tt,
+               bool logUci,
+               Settings settings) :
     _limits(limits),
     _initialBoard(board),
     _logUci(logUci),
+    _maxTimeAllocated(0),
     _stop(false),
-    _limitCheckCount(0),
+    _tt(tt),
+    _hashMoveFallback(settings.hashMoveFallback),
     _bestScore(0) {
 
+  for (int id = 0; id < std::max(settings.threads, 1); id++) {
+    _threads.push_back(std::unique_ptr<ThreadData>(new ThreadData(id, _initialBoard, _tt, positionHistory)));
+  }
+
   if (_limits.infinite) { // Infinite search
     _searchDepth = INF;
     _timeAllocated = INF;
@@ -49,35 +80,127 @@ Search::Search(const Board &board, Limits limits, std::vector<ZKey> positionHist
     // Use all of the increment to think
     _timeAllocated += _limits.increment[_initialBoard.getActivePlayer()];
 
+    // Allow up to twice the allocated time when the best move turns out to be
+    // worse than expected, but never more than a quarter of our time
+    _maxTimeAllocated = std::max(_timeAllocated, std::min(_timeAllocated * 2, ourTime / 4));
+
     // Depth is infinity in a timed search (ends when time runs out)
     _searchDepth = MAX_SEARCH_DEPTH;
   } else { // No limits specified, use default depth
     _searchDepth = DEFAULT_SEARCH_DEPTH;
     _timeAllocated = INF;
   }
+
+  // Only timed searches may extend their allocated time
+  _maxTimeAllocated = std::max(_maxTimeAllocated, _timeAllocated);
 }
 
 void Search::iterDeep() {
   _start = std::chrono::steady_clock::now();
+  _tt->newSearch();
 
-  for (int currDepth = 1; currDepth <= _searchDepth; currDepth++) {
-    _rootMax(_initialBoard, currDepth);
+  // Start helper threads, these search the same tree as the main thread and
+  // share information with it only through the transposition table
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < _threads.size(); i++) {
+    helpers.push_back(std::thread(&Search::_iterDeep, this, std::ref(*_threads[i])));
+  }
 
-    int elapsed =
-        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+  _iterDeep(*_threads[0]);
 
-    // If limits were exceeded in the search, break without logging UCI info (search was incomplete)
-    if (_stop) break;
+  // The main thread is done, stop all helpers
+  _stop = true;
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+
+  if (_logUci) std::cout << "bestmove " << getBestMove().getNotation() << std::endl;
+}
+
+void Search::_iterDeep(ThreadData &td) {
+  // The search stack bounds the depth of infinite searches
+  int maxDepth = std::min(_searchDepth, SearchStack::MAX_PLY - 1);
+  for (int currDepth = 1; currDepth <= maxDepth; currDepth++) {
+    // Helper threads skip some depths so that they don't all search the same iteration
+    if (td.id != 0) {
+      int i = (td.id - 1) % SKIP_TABLE_SIZE;
+      if (((currDepth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2) continue;
+    }
+
+    _aspirationSearch(td, currDepth);
+
+    // If limits were exceeded in the search, break without logging UCI info
+    // (search was incomplete), keeping any move that failed high in it
+    if (_stop) {
+      if (td.id == 0) {
+        _bestMove = td.bestMove;
+        _bestScore = td.bestScore;
+      }
+      break;
+    }
+
+    // Only the main thread reports results and manages time
+    if (td.id != 0) continue;
+
+    int elapsed = _getElapsed();
+
+    _bestMove = td.bestMove;
+    _bestScore = td.bestScore;
 
     if (_logUci) {
-      _logUciInfo(_getPv(currDepth), currDepth, _bestScore, _nodes, elapsed);
+      _logUciInfo(_getPv(currDepth), currDepth, _bestScore, TranspTableEntry::EXACT, getNodes(), elapsed);
     }
 
     // If the last search has exceeded or hit 50% of the allocated time, stop searching
     if (elapsed >= (_timeAllocated / 2)) break;
   }
+}
 
-  if (_logUci) std::cout << "bestmove " << getBestMove().getNotation() << std::endl;
+void Search::_aspirationSearch(ThreadData &td, int depth) {
+  int previousScore = td.bestScore;
+
+  // Search shallow depths, and positions where a mate was found, with a full window
+  if (depth < ASPIRATION_MIN_DEPTH || std::abs(previousScore) >= MATE_BOUND) {
+    _rootMax(td, depth, -INF, INF);
+    return;
+  }
+
+  int delta = ASPIRATION_WINDOW;
+  int alpha = previousScore - delta;
+  int beta = previousScore + delta;
+
+  while (true) {
+    int score = _rootMax(td, depth, alpha, beta);
+    if (_stop) return;
+
+    // A bound that is already infinite can't fail, the score is exact
+    TranspTableEntry::Flag bound;
+    if (score <= alpha && alpha != -INF) {
+      bound = TranspTableEntry::UPPER_BOUND;
+
+      // Keep beta close, the score is likely to end up near alpha
+      if (beta != INF) beta = (alpha + beta) / 2;
+      alpha = (score <= -MATE_BOUND || delta >= ASPIRATION_MAX_WINDOW) ? -INF : score - delta;
+
+      // The best move is worse than expected, allow more time to find a better one
+      if (td.id == 0) _timeAllocated = _maxTimeAllocated;
+    } else if (score >= beta && beta != INF) {
+      bound = TranspTableEntry::LOWER_BOUND;
+      beta = (score >= MATE_BOUND || delta >= ASPIRATION_MAX_WINDOW) ? INF : score + delta;
+    } else {
+      return;
+    }
+
+    if (_logUci && td.id == 0) {
+      _logUciInfo(_getPv(depth), depth, score, bound, getNodes(), _getElapsed());
+    }
+
+    delta += delta / 2;
+  }
+}
+
+int Search::_getElapsed() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
 }
 
 MoveList Search::_getPv(int length) {
@@ -86,29 +209,44 @@ MoveList Search::_getPv(int length) {
   const TranspTableEntry *currEntry;
   int currLength = 0;
 
-  while (currLength++ < length && (currEntry = _tt.getEntry(currBoard.getZKey()))) {
-    pv.push_back(currEntry->getBestMove());
-    currBoard.doMove(currEntry->getBestMove());
+  while (currLength++ < length && pv.size() < MoveList::MAX_SIZE && (currEntry = _tt->getEntry(currBoard.getZKey()))) {
+    // Stop at the first move that isn't legal (the entry belongs to another
+    // position with the same bucket and key bits, or was torn by another thread)
+    Move move = currEntry->getBestMove();
+    if (!MoveGen::isLegal(currBoard, move)) {
+      break;
+    }
+
+    pv.push_back(move);
+    currBoard.doMove(move);
   }
 
   return pv;
 }
 
-void Search::_logUciInfo(const MoveList &pv, int depth, int bestScore, int nodes, int elapsed) {
+void Search::_logUciInfo(const MoveList &pv, int depth, int bestScore, TranspTableEntry::Flag bound, U64 nodes,
+                         int elapsed) {
   std::string pvString;
   for (auto move : pv) {
     pvString += move.getNotation() + " ";
   }
 
   std::string scoreString;
-  if (bestScore == INF) {
-    scoreString = "mate " + std::to_string(pv.size());
-  } else if (_bestScore == -INF) {
-    scoreString = "mate -" + std::to_string(pv.size());
+  // Mate scores are given in moves rather than plies
+  if (bestScore >= MATE_BOUND) {
+    scoreString = "mate " + std::to_string((MATE - bestScore + 1) / 2);
+  } else if (bestScore <= -MATE_BOUND) {
+    scoreString = "mate -" + std::to_string((MATE + bestScore) / 2);
   } else {
     scoreString = "cp " + std::to_string(bestScore);
   }
 
+  if (bound == TranspTableEntry::LOWER_BOUND) {
+    scoreString += " lowerbound";
+  } else if (bound == TranspTableEntry::UPPER_BOUND) {
+    scoreString += " upperbound";
+  }
+
   // Avoid divide by zero errors with nps
   elapsed++;
 
@@ -129,103 +267,243 @@ Move Search::getBestMove() {
   return _bestMove;
 }
 
-bool Search::_checkLimits() {
-  if (--_limitCheckCount > 0) {
+int Search::getBestScore() const {
+  return _bestScore;
+}
+
+U64 Search::getNodes() const {
+  U64 nodes = 0;
+  for (auto &td : _threads) {
+    nodes += td->nodes.load(std::memory_order_relaxed);
+  }
+  return nodes;
+}
+
+bool Search::_checkLimits(ThreadData &td) {
+  if (--td.limitCheckCount > 0) {
     return false;
   }
 
-  _limitCheckCount = 4096;
+  td.limitCheckCount = 4096;
+
+  // Helper threads are stopped by the main thread
+  if (td.id != 0) {
+    return false;
+  }
 
-  int elapsed =
-      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+  int elapsed = _getElapsed();
 
-  if (_limits.nodes != 0 && (_nodes >= _limits.nodes)) return true;
+  if (_limits.nodes != 0 && (getNodes() >= static_cast<U64>(_limits.nodes))) return true;
   if (elapsed >= (_timeAllocated)) return true;
 
   return false;
 }
 
-void Search::_rootMax(const Board &board, int depth) {
-  MoveGen movegen(board);
-  MoveList legalMoves = movegen.getLegalMoves();
-  _nodes = 0;
+int Search::_rootMax(ThreadData &td, int depth, int alpha, int beta) {
+  Board &board = td.board;
+  Color us = board.getActivePlayer();
+  SearchStack *ss = td.rootStack();
+  GeneralMovePicker movePicker(&td.orderingInfo, &board, ss);
 
   // If no legal moves are available, just return, setting bestmove to a null move
-  if (legalMoves.empty()) {
-    _bestMove = Move();
-    _bestScore = -INF;
-    return;
+  if (!movePicker.hasNext()) {
+    td.bestMove = Move();
+    td.bestScore = board.colorIsInCheck(us) ? -MATE : 0;
+    return td.bestScore;
   }
 
-  GeneralMovePicker movePicker
-      (&_orderingInfo, const_cast<Board *>(&board), &legalMoves);
-
-  int alpha = -INF;
-  int beta = INF;
-
+  int alphaOrig = alpha;
   int currScore;
+  int bestScore = -INF;
 
+  Move firstMove;
   Move bestMove;
   bool fullWindow = true;
   while (movePicker.hasNext()) {
     Move move = movePicker.getNext();
+    if (firstMove.getFlags() & Move::NULL_MOVE) {
+      firstMove = move;
+    }
 
-    Board movedBoard = board;
-    movedBoard.doMove(move);
+    board.doMove(move);
+    ss->currentMove = move;
+    ss->continuationHistory = td.orderingInfo.getContinuationHistoryTable(us, move);
 
-    _orderingInfo.incrementPly();
     if (fullWindow) {
-      currScore = -_negaMax(movedBoard, depth - 1, -beta, -alpha);
+      currScore = -_negaMax(td, ss + 1, depth - 1, -beta, -alpha);
     } else {
-      currScore = -_negaMax(movedBoard, depth - 1, -alpha - 1, -alpha);
-      if (currScore > alpha) currScore = -_negaMax(movedBoard, depth - 1, -beta, -alpha);
+      currScore = -_negaMax(td, ss + 1, depth - 1, -alpha - 1, -alpha);
+      if (currScore > alpha) currScore = -_negaMax(td, ss + 1, depth - 1, -beta, -alpha);
     }
-    _orderingInfo.deincrementPly();
+    board.undoMove();
 
-    if (_stop || _checkLimits()) {
+    // Only the first move is searched with a full window, the rest only need
+    // to be proven worse than it
+    fullWindow = false;
+
+    if (_stop || _checkLimits(td)) {
       _stop = true;
       break;
     }
 
+    // Fail high, the score is only a lower bound (a mate found with a full
+    // window is an exact score)
+    if (currScore >= beta && beta != INF) {
+      if (!_stop) {
+        TranspTableEntry ttEntry(currScore, depth, TranspTableEntry::LOWER_BOUND, move);
+        _tt->set(board.getZKey(), ttEntry);
+
+        // The move beats the previous iteration's best move, so it is played
+        // if the search is stopped before the re-search completes
+        td.bestMove = move;
+        td.bestScore = currScore;
+      }
+      return currScore;
+    }
+
+    bestScore = std::max(bestScore, currScore);
+
     // If the current score is better than alpha, or this is the first move in the loop
     if (currScore > alpha) {
-      fullWindow = false;
       bestMove = move;
       alpha = currScore;
-
-      // Break if we've found a checkmate
-      if (currScore == INF) {
-        break;
-      }
     }
   }
 
+  // Fail low, keep the best move from the previous iteration (with a full
+  // window, every move is getting mated and the first one is picked below)
+  if (bestScore <= alphaOrig && alphaOrig != -INF) {
+    return bestScore;
+  }
+
   // If the best move was not set in the main search loop
   // alpha was not raised at any point, just pick the first move
-  // avaliable (arbitrary) to avoid putting a null move in the
+  // searched (arbitrary) to avoid putting a null move in the
   // transposition table
   if (bestMove.getFlags() & Move::NULL_MOVE) {
-    bestMove = legalMoves.at(0);
+    bestMove = firstMove;
   }
 
   if (!_stop) {
     TranspTableEntry ttEntry(alpha, depth, TranspTableEntry::EXACT, bestMove);
-    _tt.set(board.getZKey(), ttEntry);
+    _tt->set(board.getZKey(), ttEntry);
+
+    td.bestMove = bestMove;
+    td.bestScore = alpha;
+  }
+
+  return alpha;
+}
+
+int Search::_lateMoveReduction(const ThreadData &td, const SearchStack *ss, Move move, int depth, int moveNumber,
+                               bool pvNode) {
+  int reduction = _lmrTable[std::min(depth, 63)][std::min(moveNumber, 63)];
+
+  if (move == ss->killer1 || move == ss->killer2) {
+    reduction--;
+  }
+
+  // Reduce moves that have caused cutoffs less, and moves that haven't more
+  Color color = td.board.getActivePlayer();
+  int history = td.orderingInfo.getHistory(color, move.getFrom(), move.getTo())
+      + (ss - 1)->getContinuationHistory(1, move)
+      + (ss - 2)->getContinuationHistory(2, move);
+  reduction -= history / LMR_HISTORY_DIVISOR;
+
+  // Positions that are getting worse are less likely to hold a good late move
+  if (!ss->improving) {
+    reduction++;
+  }
+
+  if (pvNode) {
+    reduction--;
+  }
+
+  return std::max(reduction, 0);
+}
+
+int Search::_nullMoveReduction(int depth) {
+  return 3 + depth / 6;
+}
 
-    _bestMove = bestMove;
-    _bestScore = alpha;
+void Search::_updateHistories(ThreadData &td, const SearchStack *ss, Move move, const MoveList &quietsSearched,
+                              const MoveList &capturesSearched, int depth) {
+  OrderingInfo &orderingInfo = td.orderingInfo;
+  Color color = td.board.getActivePlayer();
+  Move previous1 = (ss - 1)->currentMove;
+  Move previous2 = (ss - 2)->currentMove;
+
+  if (!(move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT))) {
+    orderingInfo.updateCounterMove(color, previous1, move);
+    orderingInfo.incrementHistory(color, move.getFrom(), move.getTo(), depth);
+    orderingInfo.incrementContinuationHistory(color, 1, previous1, move, depth);
+    orderingInfo.incrementContinuationHistory(color, 2, previous2, move, depth);
+
+    for (auto quiet : quietsSearched) {
+      orderingInfo.decrementHistory(color, quiet.getFrom(), quiet.getTo(), depth);
+      orderingInfo.decrementContinuationHistory(color, 1, previous1, quiet, depth);
+      orderingInfo.decrementContinuationHistory(color, 2, previous2, quiet, depth);
+    }
+  } else if (move.getFlags() & (Move::CAPTURE | Move::EN_PASSANT)) {
+    orderingInfo.incrementCaptureHistory(color, move, depth);
+  }
+
+  for (auto capture : capturesSearched) {
+    orderingInfo.decrementCaptureHistory(color, capture, depth);
   }
 }
 
-int Search::_negaMax(const Board &board, int depth, int alpha, int beta) {
+bool Search::_isRepetition(const ThreadData &td, const SearchStack *ss) {
+  int index = td.rootKeyIndex + ss->ply;
+  U64 key = td.keys[index];
+  int maxDistance = std::min(td.board.getHalfmoveClock(), index);
+
+  for (int distance = 2; distance <= maxDistance; distance += 2) {
+    // Positions before a null move on the search path were not really repeated
+    if (distance <= ss->ply
+        && (((ss - distance)->currentMove.getFlags() | (ss - distance + 1)->currentMove.getFlags()) & Move::NULL_MOVE)) {
+      return false;
+    }
+
+    if (td.keys[index - distance] == key) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int Search::_scoreToTt(int score, int ply) {
+  if (score >= MATE_BOUND) {
+    return score + ply;
+  } else if (score <= -MATE_BOUND) {
+    return score - ply;
+  }
+  return score;
+}
+
+int Search::_scoreFromTt(int score, int ply) {
+  if (score >= MATE_BOUND) {
+    return score - ply;
+  } else if (score <= -MATE_BOUND) {
+    return score + ply;
+  }
+  return score;
+}
+
+int Search::_negaMax(ThreadData &td, SearchStack *ss, int depth, int alpha, int beta, bool nullAllowed) {
+  Board &board = td.board;
+
   // Check search limits
-  if (_stop || _checkLimits()) {
+  if (_stop || _checkLimits(td)) {
     _stop = true;
     return 0;
   }
 
-  // Check for threefold repetition draws
-  if (std::find(_positionHistory.begin(), _positionHistory.end(), board.getZKey()) != _positionHistory.end()) {
+  // Check for repetition draws (a position that has occurred once before is
+  // already scored as a draw, as it could be repeated again)
+  td.keys[td.rootKeyIndex + ss->ply] = board.getZKey().getValue();
+  if (_isRepetition(td, ss)) {
     return 0;
   }
 
@@ -234,158 +512,496 @@ int Search::_negaMax(const Board &board, int depth, int alpha, int beta) {
     return 0;
   }
 
+  // The search stack is full, only resolve captures from here
+  if (ss->ply >= SearchStack::MAX_PLY - 1) {
+    return _qSearch(td, alpha, beta, ss->ply);
+  }
+
+  // Mate distance pruning, no score can be better than mating on the next
+  // move or worse than getting mated right here
+  alpha = std::max(alpha, -MATE + ss->ply);
+  beta = std::min(beta, MATE - ss->ply - 1);
+  if (alpha >= beta) {
+    return alpha;
+  }
+
+  // An excluded move search looks at the same position as the node that
+  // started it, so it can't use that node's transposition table entry
+  bool excludedSearch = !(ss->excludedMove.getFlags() & Move::NULL_MOVE);
+
   int alphaOrig = alpha;
-  const TranspTableEntry *ttEntry = _tt.getEntry(board.getZKey());
-  // Check transposition table cache
-  if (ttEntry && (ttEntry->getDepth() >= depth)) {
+  const TranspTableEntry *ttEntry = _tt->getEntry(board.getZKey());
+  int ttScore = ttEntry ? _scoreFromTt(ttEntry->getScore(), ss->ply) : 0;
+  int ttDepth = ttEntry ? ttEntry->getDepth() : 0;
+  // Check transposition table cache, the window is left untouched so that
+  // the bound stored for this node below matches the window it was searched with
+  if (!excludedSearch && ttEntry && ttDepth >= depth) {
     switch (ttEntry->getFlag()) {
-      case TranspTable::EXACT:return ttEntry->getScore();
-      case TranspTable::UPPER_BOUND:beta = std::min(beta, ttEntry->getScore());
+      case TranspTable::EXACT:return ttScore;
+      case TranspTable::UPPER_BOUND:
+        if (ttScore <= alpha) return ttScore;
         break;
-      case TranspTable::LOWER_BOUND:alpha = std::max(alpha, ttEntry->getScore());
+      case TranspTable::LOWER_BOUND:
+        if (ttScore >= beta) return ttScore;
         break;
     }
-
-    if (alpha >= beta) {
-      return ttEntry->getScore();
-    }
   }
 
-  // Transposition table lookups are inconclusive, generate moves and recurse
-  MoveGen movegen(board);
-  MoveList legalMoves = movegen.getLegalMoves();
+  bool hasHashMove = ttEntry && !(ttEntry->getBestMove().getFlags() & Move::NULL_MOVE);
 
-  // Check for checkmate and stalemate
-  if (legalMoves.empty()) {
-    int score = board.colorIsInCheck(board.getActivePlayer()) ? -INF : 0; // -INF = checkmate, 0 = stalemate (draw)
-    return score;
-  }
+  // The hash move may be extended if its score is at least ttScore and was
+  // found by a search not much shallower than this one. The entry is copied
+  // as it may be replaced by the time the hash move is searched.
+  Move ttMove = hasHashMove ? ttEntry->getBestMove() : Move();
+  bool singularCandidate = hasHashMove && !excludedSearch && depth >= SINGULAR_MIN_DEPTH
+      && ttEntry->getFlag() != TranspTable::UPPER_BOUND
+      && ttDepth >= depth - SINGULAR_TT_DEPTH_MARGIN
+      && std::abs(ttScore) < MATE_BOUND;
 
   // Extend when evading check
+  bool inCheck = board.colorIsInCheck(board.getActivePlayer());
   int checkExtension = 0;
-  if (board.colorIsInCheck(board.getActivePlayer())) {
+  if (inCheck) {
     checkExtension = 1;
   }
 
-  // Eval if depth is 0
-  if ((depth + checkExtension) == 0) {
-    return _qSearch(board, alpha, beta);
+  // Eval if depth is 0 (quiescence search detects checkmate and stalemate itself)
+  if ((depth + checkExtension) <= 0) {
+    return _qSearch(td, alpha, beta, ss->ply);
+  }
+
+  bool pvNode = alpha + 1 != beta;
+  Color us = board.getActivePlayer();
+
+  // Static evaluation used by the pruning below (which is never done in
+  // check), reused from the transposition table if possible
+  int staticEval = TranspTableEntry::NO_EVAL;
+  if (!inCheck) {
+    staticEval = ttEntry ? ttEntry->getEval() : TranspTableEntry::NO_EVAL;
+    if (staticEval == TranspTableEntry::NO_EVAL) {
+      staticEval = Eval::evaluate(board, us);
+    }
+  }
+
+  // The position is improving if the static eval is better than it was on
+  // our last move (or if that can't be told)
+  ss->inCheck = inCheck;
+  ss->staticEval = staticEval;
+  ss->improving = !inCheck
+      && ((ss - 2)->staticEval == TranspTableEntry::NO_EVAL || staticEval > (ss - 2)->staticEval);
+
+  // The node that started an excluded move search already decided not to
+  // prune its position, so the pruning below is skipped in those searches.
+  //
+  // Reverse futility pruning, if the static eval beats beta by a margin that
+  // grows with depth (and is smaller if improving), assume that some move
+  // will beat beta too
+  if (!pvNode && !inCheck && !excludedSearch && depth <= RFP_MAX_DEPTH && staticEval - RFP_MARGIN * (depth - ss->improving) >= beta) {
+    return staticEval;
+  }
+
+  // Razoring, if the static eval is far below alpha, only captures are likely
+  // to raise it, so verify with a quiescence search
+  if (!pvNode && !inCheck && !excludedSearch && depth <= RAZOR_MAX_DEPTH && staticEval + RAZOR_MARGIN[depth] <= alpha) {
+    int score = _qSearch(td, alpha, alpha + 1, ss->ply);
+    if (depth == 1 || score <= alpha) {
+      return score;
+    }
+  }
+
+  // Null move pruning, if passing still fails high a real move will too. This
+  // is not safe in zugzwang, which is likely when only pawns are left, so skip
+  // those positions.
+  bool hasPieces = board.getAllPieces(us) != (board.getPieces(us, PAWN) | board.getPieces(us, KING));
+  if (nullAllowed && !inCheck && !excludedSearch && hasPieces && depth >= NULL_MOVE_MIN_DEPTH && !pvNode && staticEval >= beta) {
+    int reduction = _nullMoveReduction(depth);
+
+    board.doNullMove();
+    ss->currentMove = Move();
+    ss->continuationHistory = nullptr;
+    int score = -_negaMax(td, ss + 1, depth - 1 - reduction, -beta, -beta + 1, false);
+    board.undoMove();
+
+    if (_stop) {
+      return 0;
+    }
+
+    if (score >= beta) {
+      // Verify at high depths by searching without the null move
+      if (depth < NULL_MOVE_VERIFICATION_DEPTH || _negaMax(td, ss, depth - reduction, beta - 1, beta, false) >= beta) {
+        // Passing can't prove a mate
+        return score >= MATE_BOUND ? beta : score;
+      }
+    }
+  }
+
+  // ProbCut, if a capture that wins material beats beta by a margin in
+  // a quiescence search and then in a reduced search, a full search would
+  // very likely beat beta too. Skipped if the transposition table already
+  // shows a search not much shallower than the reduced one failing to do so.
+  int probCutBeta = beta + PROBCUT_MARGIN;
+  if (!pvNode && !inCheck && !excludedSearch && depth >= PROBCUT_MIN_DEPTH && beta > -MATE_BOUND
+      && probCutBeta < MATE_BOUND && !(ttEntry && ttDepth >= depth - PROBCUT_REDUCTION && ttScore < probCutBeta)) {
+    QSearchMovePicker probCutPicker(&board);
+    while (probCutPicker.hasNext()) {
+      Move move = probCutPicker.getNext();
+
+      // Only captures that win enough material to reach the raised beta
+      if (staticEval + See::evaluate(board, move) < probCutBeta) {
+        continue;
+      }
+
+      board.doMove(move);
+      ss->currentMove = move;
+      ss->continuationHistory = td.orderingInfo.getContinuationHistoryTable(us, move);
+      int score = -_qSearch(td, -probCutBeta, -probCutBeta + 1, ss->ply + 1);
+      if (score >= probCutBeta) {
+        score = -_negaMax(td, ss + 1, depth - 1 - PROBCUT_REDUCTION, -probCutBeta, -probCutBeta + 1);
+      }
+      board.undoMove();
+
+      if (_stop) {
+        return 0;
+      }
+
+      if (score >= probCutBeta) {
+        TranspTableEntry newTTEntry(_scoreToTt(score, ss->ply), depth - PROBCUT_REDUCTION,
+                                    TranspTableEntry::LOWER_BOUND, move, staticEval);
+        _tt->set(board.getZKey(), newTTEntry);
+        return score;
+      }
+    }
+  }
+
+  // Without a hash move, move ordering is likely poor. Either search the
+  // node at a reduced depth first so that its best move is stored in the
+  // transposition table, or assume the node is not important enough to
+  // be in the table and reduce it.
+  if (!hasHashMove && !excludedSearch) {
+    if (_hashMoveFallback == IID && pvNode && depth >= IID_MIN_DEPTH) {
+      _negaMax(td, ss, depth - IID_REDUCTION, alpha, beta);
+      if (_stop) {
+        return 0;
+      }
+    } else if (_hashMoveFallback == IIR && depth >= IIR_MIN_DEPTH) {
+      depth--;
+    }
   }
 
-  GeneralMovePicker movePicker
-      (&_orderingInfo, const_cast<Board *>(&board), &legalMoves);
+  // Transposition table lookups are inconclusive, recurse on moves as they
+  // are generated by the move picker
+  GeneralMovePicker movePicker(&td.orderingInfo, &board, ss);
+
+  int newDepth = depth - 1 + checkExtension;
 
+  // Quiet moves may be pruned near the leaves, but never when a mate score
+  // could be hidden behind them
+  bool mateWindow = alpha <= -MATE_BOUND || beta >= MATE_BOUND;
+  bool canPruneQuiets = !pvNode && !inCheck && !mateWindow;
+  int futilityValue = staticEval + FUTILITY_MARGIN * depth;
+  bool futile = canPruneQuiets && depth <= FUTILITY_MAX_DEPTH && futilityValue <= alpha;
+  bool lateMovePrune = canPruneQuiets && depth <= LMP_MAX_DEPTH;
+
+  Move firstMove;
   Move bestMove;
   bool fullWindow = true;
+  int movesSearched = 0;
+  MoveList quietsSearched;
+  MoveList capturesSearched;
+  int bestScore = -INF;
   while (movePicker.hasNext()) {
     Move move = movePicker.getNext();
+    if (move == ss->excludedMove) {
+      continue;
+    }
+    if (firstMove.getFlags() & Move::NULL_MOVE) {
+      firstMove = move;
+    }
 
-    Board movedBoard = board;
-    movedBoard.doMove(move);
+    // Singular extensions, search the other moves at a reduced depth against
+    // a bound just below the hash move's score. If they all fail low, the
+    // hash move is the only good move here and is extended. If the bound is
+    // at least beta and one of them beats it, several moves likely beat beta
+    // and the node is cut (multi-cut).
+    int extension = 0;
+    if (singularCandidate && move == ttMove) {
+      int singularBeta = ttScore - SINGULAR_MARGIN * depth;
+
+      ss->excludedMove = move;
+      int score = _negaMax(td, ss, (depth - 1) / 2, singularBeta - 1, singularBeta);
+      ss->excludedMove = Move();
+
+      if (_stop) {
+        return 0;
+      }
 
-    int score;
-    _orderingInfo.incrementPly();
-    if (fullWindow) {
-      score = -_negaMax(movedBoard, depth - 1 + checkExtension, -beta, -alpha);
-    } else {
-      score = -_negaMax(movedBoard, depth - 1 + checkExtension, -alpha - 1, -alpha);
-      if (score > alpha) score = -_negaMax(movedBoard, depth - 1 + checkExtension, -beta, -alpha);
+      if (score < singularBeta) {
+        extension = 1;
+      } else if (singularBeta >= beta) {
+        return singularBeta;
+      }
+    }
+
+    // Late quiet moves are unlikely to be best, consider reducing them
+    bool quiet = !(move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT));
+    int reduction = 0;
+    if (quiet && !inCheck && depth >= LMR_MIN_DEPTH && movesSearched >= LMR_MIN_MOVES) {
+      reduction = std::min(_lateMoveReduction(td, ss, move, depth, movesSearched, pvNode), newDepth - 1);
+    }
+
+    board.doMove(move);
+    bool givesCheck = board.colorIsInCheck(board.getActivePlayer());
+
+    // Futility and late move pruning, skip quiet moves that are unlikely to
+    // raise alpha (the first move is always searched so that mates are found)
+    if (quiet && !givesCheck && movesSearched > 0
+        && (futile || (lateMovePrune && movesSearched >= LMP_MOVE_COUNT[depth]))) {
+      board.undoMove();
+
+      // A futile move is assumed to score no better than the futility value
+      if (futile) bestScore = std::max(bestScore, futilityValue);
+      continue;
     }
-    _orderingInfo.deincrementPly();
+
+    // Don't reduce checks
+    if (givesCheck) {
+      reduction = 0;
+    }
+
+    int score = 0;
+    ss->currentMove = move;
+    ss->continuationHistory = td.orderingInfo.getContinuationHistoryTable(us, move);
+
+    // Reduced null window search, the move is searched normally if it beats alpha
+    if (reduction > 0) {
+      score = -_negaMax(td, ss + 1, newDepth - reduction, -alpha - 1, -alpha);
+    }
+
+    if (reduction == 0 || score > alpha) {
+      if (fullWindow) {
+        score = -_negaMax(td, ss + 1, newDepth + extension, -beta, -alpha);
+      } else {
+        score = -_negaMax(td, ss + 1, newDepth + extension, -alpha - 1, -alpha);
+        if (score > alpha && score < beta) score = -_negaMax(td, ss + 1, newDepth + extension, -beta, -alpha);
+      }
+    }
+    board.undoMove();
+
+    // The score of a stopped search is meaningless, don't let it cause
+    // cutoffs or get stored
+    if (_stop) {
+      return 0;
+    }
+
+    movesSearched++;
+
+    // Only the first move is searched with a full window, the rest only need
+    // to be proven worse than it
+    fullWindow = false;
 
     // Beta cutoff
     if (score >= beta) {
-      // Add this move as a new killer move and update history if move is quiet
-      _orderingInfo.updateKillers(_orderingInfo.getPly(), move);
-      if (!(move.getFlags() & Move::CAPTURE)) {
-        _orderingInfo.incrementHistory(board.getActivePlayer(), move.getFrom(), move.getTo(), depth);
-      }
+      // Add this move as a new killer move and update history tables
+      ss->updateKillers(move);
+      _updateHistories(td, ss, move, quietsSearched, capturesSearched, depth);
 
       // Add a new tt entry for this node
-      TranspTableEntry newTTEntry(score, depth, TranspTableEntry::LOWER_BOUND, move);
-      _tt.set(board.getZKey(), newTTEntry);
-      return beta;
+      if (!excludedSearch) {
+        TranspTableEntry newTTEntry(_scoreToTt(score, ss->ply), depth, TranspTableEntry::LOWER_BOUND, move, staticEval);
+        _tt->set(board.getZKey(), newTTEntry);
+      }
+      return score;
+    }
+
+    if (quiet) {
+      quietsSearched.push_back(move);
+    } else if (move.getFlags() & (Move::CAPTURE | Move::EN_PASSANT)) {
+      capturesSearched.push_back(move);
     }
 
+    bestScore = std::max(bestScore, score);
+
     // Check if alpha raised (new best move)
     if (score > alpha) {
-      fullWindow = false;
       alpha = score;
       bestMove = move;
     }
   }
 
+  // Check for checkmate and stalemate (unless the excluded move was the only
+  // legal move, in which case no other move beats alpha)
+  if (firstMove.getFlags() & Move::NULL_MOVE) {
+    if (excludedSearch) {
+      return alpha;
+    }
+    return inCheck ? -MATE + ss->ply : 0; // Checkmate or stalemate (draw)
+  }
+
   // If the best move was not set in the main search loop
   // alpha was not raised at any point, just pick the first move
-  // avaliable (arbitrary) to avoid putting a null move in the
+  // searched (arbitrary) to avoid putting a null move in the
   // transposition table
   if (bestMove.getFlags() & Move::NULL_MOVE) {
-    bestMove = legalMoves.at(0);
+    bestMove = firstMove;
   }
 
   // Store bestScore in transposition table
   TranspTableEntry::Flag flag;
-  if (alpha <= alphaOrig) {
+  if (bestScore <= alphaOrig) {
     flag = TranspTableEntry::UPPER_BOUND;
   } else {
     flag = TranspTableEntry::EXACT;
   }
-  TranspTableEntry newTTEntry(alpha, depth, flag, bestMove);
-  _tt.set(board.getZKey(), newTTEntry);
+  if (!excludedSearch) {
+    TranspTableEntry newTTEntry(_scoreToTt(bestScore, ss->ply), depth, flag, bestMove, staticEval);
+    _tt->set(board.getZKey(), newTTEntry);
+  }
 
-  return alpha;
+  return bestScore;
 }
 
-int Search::_qSearch(const Board &board, int alpha, int beta) {
+int Search::_qSearch(ThreadData &td, int alpha, int beta, int ply, int checkPlies) {
+  Board &board = td.board;
+
   // Check search limits
-  if (_stop || _checkLimits()) {
+  if (_stop || _checkLimits(td)) {
     _stop = true;
     return 0;
   }
 
-  MoveGen movegen(board);
-  MoveList legalMoves = movegen.getLegalMoves();
+  // Chains of checks and evasions could go on indefinitely, stop at the
+  // maximum ply and just return the static eval
+  if (ply >= SearchStack::MAX_PLY) {
+    return Eval::evaluate(board, board.getActivePlayer());
+  }
 
-  // Check for checkmate / stalemate
-  if (legalMoves.empty()) {
-    if (board.colorIsInCheck(board.getActivePlayer())) { // Checkmate
-      return -INF;
-    } else { // Stalemate
-      return 0;
+  // Check transposition table cache. Results are stored at depth 0 if quiet
+  // checks were searched and at depth -1 otherwise.
+  bool genChecks = checkPlies > 0;
+  int ttDepth = genChecks ? 0 : -1;
+  int alphaOrig = alpha;
+  const TranspTableEntry *ttEntry = _tt->getEntry(board.getZKey());
+  Move hashMove;
+  int standPat = TranspTableEntry::NO_EVAL;
+  if (ttEntry && ttEntry->getDepth() >= ttDepth) {
+    int ttScore = _scoreFromTt(ttEntry->getScore(), ply);
+    switch (ttEntry->getFlag()) {
+      case TranspTable::EXACT:return ttScore;
+      case TranspTable::UPPER_BOUND:
+        if (ttScore <= alpha) return ttScore;
+        break;
+      case TranspTable::LOWER_BOUND:
+        if (ttScore >= beta) return ttScore;
+        break;
     }
   }
+  if (ttEntry) {
+    hashMove = ttEntry->getBestMove();
+    standPat = ttEntry->getEval();
+  }
+
+  Color us = board.getActivePlayer();
+  bool inCheck = board.colorIsInCheck(us);
+  td.nodes.fetch_add(1, std::memory_order_relaxed);
+
+  // The side to move may not stand pat when in check, as every evasion may
+  // lose. Otherwise, reuse the static evaluation cached in the transposition
+  // table if possible, or use the lazy eval if it is far enough outside of the
+  // window that the full eval is unlikely to matter (lazy evals are not cached).
+  int ttEval = inCheck ? TranspTableEntry::NO_EVAL : standPat;
+  if (!inCheck) {
+    if (standPat == TranspTableEntry::NO_EVAL) {
+      standPat = Eval::evaluateLazy(board, us);
+      if (standPat - LAZY_EVAL_MARGIN < beta && standPat + LAZY_EVAL_MARGIN > alpha) {
+        standPat = Eval::evaluate(board, us);
+        ttEval = standPat;
+      }
+    }
 
-  int standPat = Eval::evaluate(board, board.getActivePlayer());
-  _nodes++;
+    if (standPat >= beta) {
+      TranspTableEntry newTTEntry(standPat, ttDepth, TranspTableEntry::LOWER_BOUND, hashMove, ttEval);
+      _tt->set(board.getZKey(), newTTEntry);
+      return standPat;
+    }
 
-  QSearchMovePicker movePicker(&legalMoves);
+    // Delta pruning, if even winning a queen (and promoting a pawn, if one is
+    // about to promote) can't raise alpha there is no point in searching any move
+    int deltaValue = standPat + Eval::getMaterialValue(QUEEN) + DELTA_MARGIN;
+    if (board.getPieces(us, PAWN) & (us == WHITE ? RANK_7 : RANK_2)) {
+      deltaValue += Eval::getMaterialValue(QUEEN) - Eval::getMaterialValue(PAWN);
+    }
+    if (deltaValue <= alpha) {
+      return deltaValue;
+    }
+  }
+
+  QSearchMovePicker movePicker(&board, hashMove, genChecks);
 
-  // If node is quiet, just return eval
   if (!movePicker.hasNext()) {
+    // Checkmate. Quiet moves are not generated when not in check, so
+    // stalemates are not detected here.
+    if (inCheck) {
+      return -MATE + ply;
+    }
+
+    // If node is quiet, just return eval
+    TranspTableEntry newTTEntry(standPat, ttDepth, TranspTableEntry::EXACT, hashMove, ttEval);
+    _tt->set(board.getZKey(), newTTEntry);
     return standPat;
   }
 
-  if (standPat >= beta) {
-    return beta;
-  }
-  if (alpha < standPat) {
+  if (!inCheck && alpha < standPat) {
     alpha = standPat;
   }
 
+  Move bestMove = hashMove;
+  int bestScore = inCheck ? -INF : standPat;
   while (movePicker.hasNext()) {
     Move move = movePicker.getNext();
 
-    Board movedBoard = board;
-    movedBoard.doMove(move);
+    // Once an evasion is known not to get mated, skip quiet evasions that lose material
+    bool quiet = !(move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT));
+    if (inCheck && quiet && bestScore > -MATE_BOUND && See::evaluate(board, move) < 0) {
+      continue;
+    }
 
-    int score = -_qSearch(movedBoard, -beta, -alpha);
+    // Delta pruning, skip captures that can't raise alpha even if the
+    // captured piece is won for free
+    if (!inCheck && (move.getFlags() & (Move::CAPTURE | Move::EN_PASSANT)) && !(move.getFlags() & Move::PROMOTION)) {
+      PieceType captured = (move.getFlags() & Move::EN_PASSANT) ? PAWN : move.getCapturedPieceType();
+      int deltaValue = standPat + Eval::getMaterialValue(captured) + DELTA_MARGIN;
+      if (deltaValue <= alpha) {
+        bestScore = std::max(bestScore, deltaValue);
+        continue;
+      }
+    }
+
+    board.doMove(move);
+
+    int score = -_qSearch(td, -beta, -alpha, ply + 1, checkPlies - 1);
+    board.undoMove();
+
+    if (_stop) {
+      return 0;
+    }
 
     if (score >= beta) {
-      return beta;
+      TranspTableEntry newTTEntry(_scoreToTt(score, ply), ttDepth, TranspTableEntry::LOWER_BOUND, move, ttEval);
+      _tt->set(board.getZKey(), newTTEntry);
+      return score;
     }
+    bestScore = std::max(bestScore, score);
     if (score > alpha) {
       alpha = score;
+      bestMove = move;
     }
   }
-  return alpha;
+
+  // The score of a quiescence search node is the best of standing pat and the
+  // moves it searches, so bestScore is a real upper bound on a fail low
+  TranspTableEntry::Flag flag = bestScore > alphaOrig ? TranspTableEntry::EXACT : TranspTableEntry::UPPER_BOUND;
+  TranspTableEntry newTTEntry(_scoreToTt(bestScore, ply), ttDepth, flag, bestMove, ttEval);
+  _tt->set(board.getZKey(), newTTEntry);
+
+  return bestScore;
 }
@@ -6,8 +6,11 @@
 #include "movegen.h"
 #include "transptable.h"
 #include "orderinginfo.h"
+#include "searchstack.h"
 #include <chrono>
 #include <atomic>
+#include <memory>
+#include <vector>
 
 /**
  * @brief Represents a search through a minmax tree.
@@ -63,17 +66,54 @@ class Search {
     int increment[2];
   };
 
+  /**
+   * @enum HashMoveFallback
+   * @brief Ways of handling nodes that have no hash move to search first.
+   */
+  enum HashMoveFallback {
+    NO_FALLBACK, /**< Search the node as is */
+    IID, /**< Run a reduced search of the node first to find a hash move (internal iterative deepening) */
+    IIR /**< Reduce the depth of the node by one (internal iterative reductions) */
+  };
+
+  /**
+   * @brief Represents engine settings (set through UCI options) that affect
+   * how a search is carried out.
+   */
+  struct Settings {
+    /**
+     * @brief Constructs a new Settings struct with all settings set to their defaults.
+     */
+    Settings() : threads(1), hashMoveFallback(IIR) {};
+
+    /**
+     * @brief Number of threads to search with (including the main thread)
+     */
+    int threads;
+
+    /**
+     * @brief How nodes without a hash move are handled
+     *
+     * IIR searched fewer nodes than IID in less time on the bench positions.
+     */
+    HashMoveFallback hashMoveFallback;
+  };
+
   /**
    * @brief Constructs a new Search for the given board.
    *
    * @param board The board to search
    * @param limits limits imposed on this search
-   * @param positionHistory Vector of ZKeys reprenting all positions that have
-   * occurred in the game
+   * @param positionHistory Vector of ZKeys representing all positions that have
+   * occurred in the game before the board's position, oldest first
+   * @param tt Transposition table to use for this search. The table is owned
+   * by the caller and is expected to outlive the Search, so that entries can
+   * be reused by later searches.
    * @param logUci If logUci is set, UCI info commands about the search will be printed
    * to standard output in real time.k
+   * @param settings Engine settings to use for this search
    */
-  Search(const Board &, Limits, std::vector<ZKey>, bool= true);
+  Search(const Board &, Limits, std::vector<ZKey>, TranspTable *, bool= true, Settings= Settings());
 
   /**
    * @brief Performs an iterative deepening search within the constraints of the given limits.
@@ -86,11 +126,36 @@ class Search {
    */
   Move getBestMove();
 
+  /**
+   * @brief Returns the score of the best move obtained through the last search
+   * performed.
+   *
+   * A score of MATE - n (or -MATE + n) means the side to move mates (or gets
+   * mated) n plies from the root.
+   *
+   * @return The score of the best move obtained through the last search
+   */
+  int getBestScore() const;
+
+  /**
+   * @brief Returns the total number of nodes searched by all threads so far.
+   *
+   * @return The total number of nodes searched by all threads so far
+   */
+  U64 getNodes() const;
+
   /**
    * @brief Instructs this Search to stop as soon as possible.
    */
   void stop();
 
+  /**
+   * @brief Initializes constants used in searching.
+   *
+   * Currently this initializes the internal _lmrTable array only.
+   */
+  static void init();
+
  private:
   /**
    * @brief Default depth to search to if no limits are specified.
@@ -111,17 +176,286 @@ class Search {
   static const int MAX_SEARCH_DEPTH = 20;
 
   /**
-   * @brief Vector of ZKeys for each position that has occurred in the game
-   * 
-   * This is used to detect threefold repetitions.
+   * @name Reverse futility pruning parameters
+   * @brief Nodes at depth RFP_MAX_DEPTH or less are pruned if their static
+   * evaluation is at least RFP_MARGIN * depth above beta (or
+   * RFP_MARGIN * (depth - 1) if the position is improving).
+   * @{
+   */
+  static const int RFP_MAX_DEPTH = 6;
+  static const int RFP_MARGIN = 90;
+  /**@}*/
+
+  /**
+   * @name Razoring parameters
+   * @brief Nodes at depth RAZOR_MAX_DEPTH or less whose static evaluation
+   * is at least RAZOR_MARGIN[depth] below alpha are verified with a
+   * quiescence search, which is returned if it doesn't beat alpha (or
+   * always at depth 1).
+   * @{
+   */
+  static const int RAZOR_MAX_DEPTH = 2;
+  static const int RAZOR_MARGIN[RAZOR_MAX_DEPTH + 1];
+  /**@}*/
+
+  /**
+   * @name Futility pruning parameters
+   * @brief At depth FUTILITY_MAX_DEPTH or less, quiet moves are pruned if
+   * the static evaluation plus FUTILITY_MARGIN * depth can't reach alpha.
+   * @{
+   */
+  static const int FUTILITY_MAX_DEPTH = 2;
+  static const int FUTILITY_MARGIN = 200;
+  /**@}*/
+
+  /**
+   * @name Late move pruning parameters
+   * @brief At depth LMP_MAX_DEPTH or less, quiet moves are pruned once
+   * LMP_MOVE_COUNT[depth] moves have been searched.
+   * @{
+   */
+  static const int LMP_MAX_DEPTH = 3;
+  static const int LMP_MOVE_COUNT[LMP_MAX_DEPTH + 1];
+  /**@}*/
+
+  /**
+   * @brief Safety margin for delta pruning in quiescence search.
+   *
+   * Captures are skipped if the stand pat score plus the value of the
+   * captured piece and this margin can't reach alpha, and whole nodes are
+   * skipped if winning a queen couldn't.
+   */
+  static const int DELTA_MARGIN = 400;
+
+  /**
+   * @brief Number of plies at the start of quiescence search in which quiet
+   * checks are searched.
+   */
+  static const int QSEARCH_CHECK_PLIES = 1;
+
+  /**
+   * @brief Distance outside of the window at which quiescence search trusts
+   * Eval::evaluateLazy() instead of running the full evaluation.
+   */
+  static const int LAZY_EVAL_MARGIN = 300;
+
+  /**
+   * @brief Minimum depth at which null move pruning is performed.
+   */
+  static const int NULL_MOVE_MIN_DEPTH = 3;
+
+  /**
+   * @brief Minimum depth at which null move cutoffs are verified with a
+   * reduced search of the position without the null move.
+   *
+   * Verification catches zugzwang positions where passing would be better
+   * than any legal move.
+   */
+  static const int NULL_MOVE_VERIFICATION_DEPTH = 10;
+
+  /**
+   * @name Internal iterative deepening parameters
+   * @brief PV nodes at depth IID_MIN_DEPTH or more without a hash move are
+   * first searched at a depth reduced by IID_REDUCTION.
+   * @{
+   */
+  static const int IID_MIN_DEPTH = 5;
+  static const int IID_REDUCTION = 2;
+  /**@}*/
+
+  /**
+   * @brief Minimum depth at which nodes without a hash move are reduced by
+   * internal iterative reductions.
+   */
+  static const int IIR_MIN_DEPTH = 4;
+
+  /**
+   * @name ProbCut parameters
+   * @brief At depth PROBCUT_MIN_DEPTH or more, non PV nodes are cut if a capture
+   * beats beta + PROBCUT_MARGIN in a search reduced by PROBCUT_REDUCTION plies.
+   *
+   * Only captures whose static exchange evaluation added to the static
+   * evaluation reaches beta + PROBCUT_MARGIN are tried.
+   * @{
+   */
+  static const int PROBCUT_MIN_DEPTH = 5;
+  static const int PROBCUT_MARGIN = 100;
+  static const int PROBCUT_REDUCTION = 4;
+  /**@}*/
+
+  /**
+   * @name Singular extension parameters
+   * @brief At depth SINGULAR_MIN_DEPTH or more, a hash move whose lower bound
+   * was found at most SINGULAR_TT_DEPTH_MARGIN plies shallower is extended if
+   * no other move comes within SINGULAR_MARGIN times the depth of its score.
+   * @{
+   */
+  static const int SINGULAR_MIN_DEPTH = 8;
+  static const int SINGULAR_TT_DEPTH_MARGIN = 3;
+  static const int SINGULAR_MARGIN = 2;
+  /**@}*/
+
+  /**
+   * @brief Minimum depth at which aspiration windows are used.
+   */
+  static const int ASPIRATION_MIN_DEPTH = 4;
+
+  /**
+   * @brief Initial distance from the previous iteration's score to each
+   * bound of the aspiration window.
    */
-  std::vector<ZKey> _positionHistory;
+  static const int ASPIRATION_WINDOW = 50;
 
   /**
-   * @brief OrderingInfo object containing information about the current state
-   * of this search
+   * @brief Window size after which a failing side of the aspiration window
+   * is opened fully.
    */
-  OrderingInfo _orderingInfo;
+  static const int ASPIRATION_MAX_WINDOW = 500;
+
+  /**
+   * @brief Minimum depth at which late move reductions are performed.
+   */
+  static const int LMR_MIN_DEPTH = 3;
+
+  /**
+   * @brief Number of moves that are searched before late move reductions
+   * start to be applied at a node.
+   */
+  static const int LMR_MIN_MOVES = 3;
+
+  /**
+   * @brief Combined quiet history (butterfly plus continuation history) that
+   * lowers the late move reduction of a move by one ply, or raises it if negative.
+   */
+  static const int LMR_HISTORY_DIVISOR = 16384;
+
+  /**
+   * @brief Base late move reductions indexed by [depth][moveNumber], both
+   * capped at 63.
+   *
+   * Reductions grow with log(depth) * log(moveNumber).
+   */
+  static int _lmrTable[64][64];
+
+  /**
+   * @brief Number of entries in Search::SKIP_SIZE and Search::SKIP_PHASE
+   */
+  static const int SKIP_TABLE_SIZE = 20;
+
+  /**
+   * @name Depth skipping tables for helper threads
+   * @brief Tables indexed by [(threadId - 1) % SKIP_TABLE_SIZE] used to
+   * decide which iterations a helper thread skips.
+   *
+   * Helper threads skip a depth if ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) is
+   * odd. This spreads helpers out over the current and next few depths so that
+   * they fill the shared transposition table with different parts of the tree.
+   * @{
+   */
+  static const int SKIP_SIZE[SKIP_TABLE_SIZE];
+  static const int SKIP_PHASE[SKIP_TABLE_SIZE];
+  /**@}*/
+
+  /**
+   * @brief Per thread state of a search.
+   *
+   * Each thread in a search owns one ThreadData object, so that everything in
+   * here can be modified without synchronization. The only exception is
+   * ThreadData::nodes, which is read by the main thread while reporting.
+   */
+  struct ThreadData {
+    /**
+     * @brief Constructs a new ThreadData for the thread with the given id.
+     *
+     * @param id Id of this thread (0 is the main thread)
+     * @param board Board to search from
+     * @param tt Transposition table shared by all threads in the search
+     * @param positionHistory Positions played before the root, oldest first
+     */
+    ThreadData(int id, const Board &board, const TranspTable *tt, const std::vector<ZKey> &positionHistory) :
+        id(id), board(board), orderingInfo(tt), rootKeyIndex(positionHistory.size()), nodes(0), limitCheckCount(0),
+        bestScore(0) {
+      for (int i = 0; i < SearchStack::SIZE; i++) {
+        stack[i].ply = i - SearchStack::OFFSET;
+      }
+
+      keys.resize(rootKeyIndex + SearchStack::MAX_PLY);
+      for (int i = 0; i < rootKeyIndex; i++) {
+        keys[i] = positionHistory[i].getValue();
+      }
+      keys[rootKeyIndex] = board.getZKey().getValue();
+    };
+
+    /**
+     * @brief Returns the entry of the root node in this thread's search stack.
+     *
+     * @return The entry of the root node in this thread's search stack
+     */
+    SearchStack *rootStack() {
+      return &stack[SearchStack::OFFSET];
+    }
+
+    /**
+     * @brief Id of this thread, the main thread has id 0
+     */
+    int id;
+
+    /**
+     * @brief Board this thread is searching, moves are made and taken back on
+     * it as the search moves through the tree
+     */
+    Board board;
+
+    /**
+     * @brief OrderingInfo object containing information about the current state
+     * of this thread's search
+     */
+    OrderingInfo orderingInfo;
+
+    /**
+     * @brief Search stack of this thread, indexed by ply + SearchStack::OFFSET
+     */
+    SearchStack stack[SearchStack::SIZE];
+
+    /**
+     * @brief Zobrist keys of the positions in the game before the root,
+     * followed by those of the nodes on the current search path, indexed by
+     * rootKeyIndex + ply
+     */
+    std::vector<U64> keys;
+
+    /**
+     * @brief Index of the root position's key in keys
+     */
+    int rootKeyIndex;
+
+    /**
+     * @brief Number of nodes searched by this thread
+     */
+    std::atomic<U64> nodes;
+
+    /**
+     * @brief Number of calls remaining to _checkLimits() before limits are
+     * actually checked
+     */
+    int limitCheckCount;
+
+    /**
+     * @brief Best move found by this thread on its last completed iteration
+     */
+    Move bestMove;
+
+    /**
+     * @brief Score corresponding to bestMove
+     */
+    int bestScore;
+  };
+
+  /**
+   * @brief Per thread state for each thread in this search (index 0 is the
+   * main thread)
+   */
+  std::vector<std::unique_ptr<ThreadData>> _threads;
 
   /**
    * @brief Limits object representing limits imposed on this search.
@@ -144,6 +478,12 @@ class Search {
    */
   int _timeAllocated;
 
+  /**
+   * @brief Time in ms that _timeAllocated may be extended to when the best
+   * move fails low
+   */
+  int _maxTimeAllocated;
+
   /**
    * @brief Depth of this search in plys
    */
@@ -152,6 +492,9 @@ class Search {
   /**
    * @brief If this flag is set, calls to _negaMax() and _rootMax() will end as soon
    * as possible and calls to _rootMax will not set the best move and best score.
+   *
+   * This flag is shared by all threads, the main thread sets it once it has
+   * finished searching to stop all helper threads.
    */
   std::atomic<bool> _stop;
 
@@ -164,27 +507,26 @@ class Search {
    * @brief Returns True if this search has exceeded its given limits 
    * 
    * Note that to avoid a needless amount of computation, limits are only
-   * checked every 4096 calls to _checkLimits() (using the Search::_limitCheckCount property).
-   * If Search::_limitCheckCount is not 0, false will be returned.
+   * checked every 4096 calls to _checkLimits() (using ThreadData::limitCheckCount).
+   * If ThreadData::limitCheckCount is not 0, false will be returned.
+   *
+   * Limits are only enforced by the main thread, helper threads always
+   * return false and instead stop when the main thread sets the stop flag.
    * 
+   * @param td ThreadData of the calling thread
    * @return True if this search has exceed its limits, true otherwise
    */
-  bool _checkLimits();
-
-  /**
-   * @brief Number of calls remaining to _checkLimits()
-   */
-  int _limitCheckCount;
+  bool _checkLimits(ThreadData &);
 
   /**
-   * @brief Number of nodes searched in the last search.
+   * @brief Transposition Table used while searching (shared by all threads).
    */
-  int _nodes;
+  TranspTable *_tt;
 
   /**
-   * @brief Transposition Table used while searching.
+   * @brief How nodes without a hash move are handled in this search
    */
-  TranspTable _tt;
+  HashMoveFallback _hashMoveFallback;
 
   /**
    * @brief Best move found on last search.
@@ -196,41 +538,172 @@ class Search {
    */
   int _bestScore;
 
+  /**
+   * @brief Performs iterative deepening on the calling thread.
+   *
+   * The main thread (id 0) records the best move and logs UCI info after each
+   * completed iteration and stops once its limits are reached. Helper threads
+   * skip some depths (see Search::SKIP_SIZE) and search until the stop flag
+   * is set.
+   *
+   * @param td ThreadData of the calling thread
+   */
+  void _iterDeep(ThreadData &);
+
+  /**
+   * @brief Searches the root position to the given depth with aspiration windows.
+   *
+   * The first search uses a window of ASPIRATION_WINDOW around the score of
+   * the previous iteration. The window is widened on the failing side until
+   * the score falls inside it. When the main thread fails low, its allocated
+   * time is extended to _maxTimeAllocated. Bounds are logged as UCI info
+   * after each failed search.
+   *
+   * @param td    ThreadData of the calling thread (td.bestScore holds the score of the previous iteration)
+   * @param depth Depth to search to
+   */
+  void _aspirationSearch(ThreadData &, int);
+
   /**
    * @brief Root negamax function.
    *
    * Starts performing a search to the given depth using recursive minimax
    * with alpha-beta pruning.
    *
-   * @param board Board to search through
-   * @param depth Depth to search to
+   * td.bestMove and td.bestScore are only set if the score falls inside the
+   * given window.
+   *
+   * @param  td    ThreadData of the calling thread (the root position is td.board)
+   * @param  depth Depth to search to
+   * @param  alpha Alpha value
+   * @param  beta  Beta value
+   * @return The score of the root position, an upper bound at most alpha on
+   * a fail low and a lower bound at least beta on a fail high
    */
-  void _rootMax(const Board &, int);
+  int _rootMax(ThreadData &, int, int, int);
 
   /**
    * @brief Non root negamax function, should only be called by _rootMax()
    *
+   * Null move pruning is performed in non PV nodes if nullAllowed is true, the
+   * side to move is not in check and has pieces other than pawns and its king.
+   * The null move is searched with a reduced depth (see _nullMoveReduction())
+   * and a cutoff is returned if it still fails high.
+   *
+   * If ss->excludedMove is set, the node is searched without that move and
+   * without touching its transposition table entry (see singular extensions).
+   *
+   * @param  td          ThreadData of the calling thread (the position to search is td.board)
+   * @param  ss          SearchStack entry of the node to search (its ply must be set)
+   * @param  depth       Plys remaining to search
+   * @param  alpha       Alpha value
+   * @param  beta        Beta value
+   * @param  nullAllowed False if a null move may not be tried at this node
+   * (eg. when the previous move was a null move)
+   * @return The score of the current board. This is fail-soft, so the score
+   * may lie outside of [alpha, beta] when it is only a bound.
+   */
+  int _negaMax(ThreadData &, SearchStack *, int, int, int, bool=true);
+
+  /**
+   * @brief Returns the depth reduction applied to a late quiet move.
+   *
+   * The base reduction is taken from _lmrTable and is lowered for killer
+   * moves and moves in PV nodes, and raised if the position is not improving.
+   * It is also adjusted by the history and continuation history of the move
+   * (see LMR_HISTORY_DIVISOR).
+   *
+   * @param  td         ThreadData of the calling thread (the move is to be made on td.board)
+   * @param  ss         SearchStack entry of the node the move is made at
+   * @param  move       Move to get the reduction for
+   * @param  depth      Plys remaining to search
+   * @param  moveNumber Number of moves searched before this one at the current node
+   * @param  pvNode     True if the current node is a PV node
+   * @return The number of plys to reduce the search of the move by
+   */
+  static int _lateMoveReduction(const ThreadData &, const SearchStack *, Move, int, int, bool);
+
+  /**
+   * @brief Returns the depth reduction applied to null move searches at the given depth.
    *
-   * @param  board Board to search
    * @param  depth Plys remaining to search
-   * @param  alpha Alpha value
-   * @param  beta  Beta value
-   * @return The score of the given board
+   * @return The number of plys to reduce a null move search by
    */
-  int _negaMax(const Board &, int, int, int);
+  static int _nullMoveReduction(int);
+
+  /**
+   * @brief Returns true if the position at the given node has occurred before
+   * in the game or on the current search path.
+   *
+   * Only every other position is checked (the side to move must be the same),
+   * going back no further than the last irreversible move according to the
+   * halfmove clock, or the last null move on the search path.
+   *
+   * @param td ThreadData of the calling thread (td.keys must hold the key of the node)
+   * @param ss SearchStack entry of the node
+   * @return true if the position at the given node is a repetition, false otherwise
+   */
+  static bool _isRepetition(const ThreadData &, const SearchStack *);
+
+  /**
+   * @brief Updates move ordering heuristics after a beta cutoff.
+   *
+   * If the move that caused the cutoff is quiet, it becomes the counter move
+   * of the last move and its history and continuation history are increased,
+   * while those of the quiet moves searched before it are decreased. If it is
+   * a capture, its capture history is increased. The capture history of
+   * captures searched before it is decreased either way.
+   *
+   * @param td               ThreadData of the calling thread (the cutoff happened at td.board)
+   * @param ss               SearchStack entry of the node the cutoff happened at
+   * @param move             Move that caused the beta cutoff
+   * @param quietsSearched   Quiet moves searched before the move
+   * @param capturesSearched Captures searched before the move
+   * @param depth            Plys remaining to search at the node
+   */
+  static void _updateHistories(ThreadData &, const SearchStack *, Move, const MoveList &, const MoveList &, int);
 
   /**
    * @brief Performs a quiescence search
    *
-   * _qSearch only takes into account captures (checks, promotions are not
-   * considered)
+   * _qSearch takes into account captures and promotions, and quiet checks
+   * in its first QSEARCH_CHECK_PLIES plies. When in check, all evasions are
+   * searched instead and the side to move may not stand pat.
    *
-   * @param  board Board to perform a quiescence search on
-   * @param  alpha Alpha value
-   * @param  beta  Beta value
-   * @return The score of the given board
+   * @param  td         ThreadData of the calling thread (the position to search is td.board)
+   * @param  alpha      Alpha value
+   * @param  beta       Beta value
+   * @param  ply        Number of plies from the root to the current board
+   * @param  checkPlies Number of plies left in which quiet checks are searched
+   * @return The score of the current board. This is fail-soft, so the score
+   * may lie outside of [alpha, beta] when it is only a bound.
+   */
+  int _qSearch(ThreadData &, int, int, int, int= QSEARCH_CHECK_PLIES);
+
+  /**
+   * @brief Converts a score found at the given ply to the form stored in the
+   * transposition table.
+   *
+   * Mate scores are stored relative to the node they are stored for rather
+   * than to the root, as the same node may be reached at other plies.
+   *
+   * @param  score Score to convert
+   * @param  ply   Number of plies from the root to the node the score is for
+   * @return The score to store in the transposition table
+   */
+  static int _scoreToTt(int, int);
+
+  /**
+   * @brief Converts a score stored in the transposition table to a score
+   * relative to the root, for a node at the given ply.
+   *
+   * This is the inverse of _scoreToTt().
+   *
+   * @param  score Score from the transposition table
+   * @param  ply   Number of plies from the root to the node the score is for
+   * @return The score relative to the root
    */
-  int _qSearch(const Board &, int= -INF, int= INF);
+  static int _scoreFromTt(int, int);
 
   /**
    * @brief Logs info about a search according to the UCI protocol.
@@ -238,10 +711,18 @@ class Search {
    * @param pv        MoveList representing the Principal Variation (first moves at index 0)
    * @param depth     Depth of search
    * @param bestScore Score corresponding to the best move
+   * @param bound     TranspTableEntry::EXACT, or the type of bound bestScore is if the search failed
    * @param nodes     Number of nodes searched
    * @param elapsed   Time taken to complete the search in milliseconds
    */
-  void _logUciInfo(const MoveList &, int, int, int, int);
+  void _logUciInfo(const MoveList &, int, int, TranspTableEntry::Flag, U64, int);
+
+  /**
+   * @brief Returns the time elapsed since this search was started in milliseconds.
+   *
+   * @return The time elapsed since this search was started in milliseconds
+   */
+  int _getElapsed() const;
 
   /**
    * @brief Returns the principal variation for the last performed search.
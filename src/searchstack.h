@@ -0,0 +1,113 @@
+#ifndef SEARCHSTACK_H
+#define SEARCHSTACK_H
+
+#include "move.h"
+#include "orderinginfo.h"
+#include "transptable.h"
+
+/**
+ * @brief Information about a single node on the path from the root to the
+ * node currently being searched.
+ *
+ * Each search thread keeps an array of SearchStack entries indexed by ply,
+ * with SearchStack::OFFSET empty entries before the root. A node can thus
+ * look back at what happened at its ancestors (such as the moves leading to
+ * it or their static evaluations) without recomputing anything.
+ */
+struct SearchStack {
+  /**
+   * @brief Maximum number of plies the main search may go from the root.
+   */
+  static const int MAX_PLY = 128;
+
+  /**
+   * @brief Number of empty entries before the root entry in a stack.
+   */
+  static const int OFFSET = 2;
+
+  /**
+   * @brief Total number of entries in a stack.
+   */
+  static const int SIZE = MAX_PLY + OFFSET;
+
+  /**
+   * @brief Constructs a new empty SearchStack entry.
+   */
+  SearchStack() :
+      ply(0), staticEval(TranspTableEntry::NO_EVAL), inCheck(false), improving(false),
+      continuationHistory(nullptr) {};
+
+  /**
+   * @brief Makes the given move the first killer move at this ply, moving
+   * the previous first killer to the second slot.
+   *
+   * @param move Move that caused a beta cutoff at this ply
+   */
+  void updateKillers(Move move) {
+    if (!(move == killer1)) {
+      killer2 = killer1;
+      killer1 = move;
+    }
+  }
+
+  /**
+   * @brief Returns the continuation history of the given move following the
+   * move made at this ply.
+   *
+   * @param plies Number of plies between this ply and the move (1 or 2)
+   * @param move Move to get continuation history for
+   * @return The continuation history of the move, or 0 if no move (or a null move) was made at this ply
+   */
+  int getContinuationHistory(int plies, Move move) const {
+    return continuationHistory ? (*continuationHistory)[plies - 1][move.getPieceType()][move.getTo()] : 0;
+  }
+
+  /**
+   * @brief Number of plies from the root to this node
+   */
+  int ply;
+
+  /**
+   * @brief Static evaluation of this node, TranspTableEntry::NO_EVAL if the
+   * side to move is in check or the node was not searched
+   */
+  int staticEval;
+
+  /**
+   * @brief True if the side to move is in check at this node
+   */
+  bool inCheck;
+
+  /**
+   * @brief True if the static evaluation of this node is better than it was
+   * two plies ago (or couldn't be compared)
+   */
+  bool improving;
+
+  /**
+   * @brief Move currently being searched at this node (a null move during null
+   * move pruning)
+   */
+  Move currentMove;
+
+  /**
+   * @brief Move that may not be searched at this node
+   */
+  Move excludedMove;
+
+  /**
+   * @brief Killer moves at this ply
+   * @{
+   */
+  Move killer1;
+  Move killer2;
+  /**@}*/
+
+  /**
+   * @brief Continuation history values of moves following currentMove, nullptr
+   * for null moves
+   */
+  const OrderingInfo::ContinuationHistory *continuationHistory;
+};
+
+#endif
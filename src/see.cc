@@ -0,0 +1,99 @@
+#include "see.h"
+#include "attacks.h"
+#include "eval.h"
+#include "bitutils.h"
+#include <algorithm>
+
+U64 See::detail::_getAttackers(const Board &board, int square, U64 occupied) {
+  U64 bishopsQueens = board.getPieces(WHITE, BISHOP) | board.getPieces(BLACK, BISHOP)
+      | board.getPieces(WHITE, QUEEN) | board.getPieces(BLACK, QUEEN);
+  U64 rooksQueens = board.getPieces(WHITE, ROOK) | board.getPieces(BLACK, ROOK)
+      | board.getPieces(WHITE, QUEEN) | board.getPieces(BLACK, QUEEN);
+
+  // A white pawn attacks the square if a black pawn on the square would attack it (and vice versa)
+  return (Attacks::getNonSlidingAttacks(PAWN, square, BLACK) & board.getPieces(WHITE, PAWN))
+      | (Attacks::getNonSlidingAttacks(PAWN, square, WHITE) & board.getPieces(BLACK, PAWN))
+      | (Attacks::getNonSlidingAttacks(KNIGHT, square) & (board.getPieces(WHITE, KNIGHT) | board.getPieces(BLACK, KNIGHT)))
+      | (Attacks::getNonSlidingAttacks(KING, square) & (board.getPieces(WHITE, KING) | board.getPieces(BLACK, KING)))
+      | (Attacks::getSlidingAttacks(BISHOP, square, occupied) & bishopsQueens)
+      | (Attacks::getSlidingAttacks(ROOK, square, occupied) & rooksQueens);
+}
+
+U64 See::detail::_getLeastValuableAttacker(const Board &board, Color color, U64 attackers, PieceType &pieceType) {
+  for (auto currPieceType : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+    U64 pieces = attackers & board.getPieces(color, currPieceType);
+    if (pieces) {
+      pieceType = currPieceType;
+      return pieces & -pieces;
+    }
+  }
+
+  return ZERO;
+}
+
+int See::evaluate(const Board &board, Move move) {
+  int to = move.getTo();
+  Color color = board.getInactivePlayer();
+  U64 occupied = board.getOccupied() ^ (ONE << move.getFrom());
+
+  // gains[i] is the material gained by the i-th capture in the sequence,
+  // assuming the piece making it is then recaptured
+  int gains[32];
+  int depth = 0;
+
+  if (move.getFlags() & Move::CAPTURE) {
+    gains[0] = Eval::getMaterialValue(move.getCapturedPieceType());
+  } else if (move.getFlags() & Move::EN_PASSANT) {
+    gains[0] = Eval::getMaterialValue(PAWN);
+    occupied ^= ONE << (board.getActivePlayer() == WHITE ? to - 8 : to + 8);
+  } else {
+    gains[0] = 0;
+  }
+
+  // Value of the piece on the capture square that is next to be captured
+  int onSquare = Eval::getMaterialValue(move.getPieceType());
+  if (move.getFlags() & Move::PROMOTION) {
+    onSquare = Eval::getMaterialValue(move.getPromotionPieceType());
+    gains[0] += onSquare - Eval::getMaterialValue(PAWN);
+  }
+
+  U64 bishopsQueens = board.getPieces(WHITE, BISHOP) | board.getPieces(BLACK, BISHOP)
+      | board.getPieces(WHITE, QUEEN) | board.getPieces(BLACK, QUEEN);
+  U64 rooksQueens = board.getPieces(WHITE, ROOK) | board.getPieces(BLACK, ROOK)
+      | board.getPieces(WHITE, QUEEN) | board.getPieces(BLACK, QUEEN);
+
+  U64 attackers = detail::_getAttackers(board, to, occupied) & occupied;
+
+  while (depth < 31) {
+    PieceType pieceType;
+    U64 attacker = detail::_getLeastValuableAttacker(board, color, attackers, pieceType);
+    if (!attacker) {
+      break;
+    }
+
+    // The king can't recapture onto a square that is still defended
+    if (pieceType == KING && (attackers & board.getAllPieces(getOppositeColor(color)))) {
+      break;
+    }
+
+    depth++;
+    gains[depth] = onSquare - gains[depth - 1];
+    onSquare = Eval::getMaterialValue(pieceType);
+
+    // Remove the attacker and add any sliders behind it
+    occupied ^= attacker;
+    attackers |= (Attacks::getSlidingAttacks(BISHOP, to, occupied) & bishopsQueens)
+        | (Attacks::getSlidingAttacks(ROOK, to, occupied) & rooksQueens);
+    attackers &= occupied;
+
+    color = getOppositeColor(color);
+  }
+
+  // Each side may choose not to recapture
+  while (depth > 0) {
+    gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+    depth--;
+  }
+
+  return gains[0];
+}
@@ -0,0 +1,59 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "defs.h"
+#include "board.h"
+#include "move.h"
+
+/**
+ * @brief Namespace containing static exchange evaluation functions
+ *
+ * Static exchange evaluation (SEE) determines the material gained or lost by
+ * a capture if both sides keep recapturing on the capture square with their
+ * least valuable attacker, stopping whenever recapturing would lose material.
+ */
+namespace See {
+namespace detail {
+/**
+ * @brief Returns a bitboard of all pieces of both colors that attack the
+ * given square given the pieces in the occupied bitboard.
+ *
+ * Pieces that are not in the occupied bitboard may be returned and must be
+ * masked out by the caller.
+ *
+ * @param board Board to get attackers on
+ * @param square Square to get attackers of
+ * @param occupied Bitboard of pieces that block sliding pieces
+ * @return A bitboard of all pieces attacking the given square
+ */
+U64 _getAttackers(const Board &, int, U64);
+
+/**
+ * @brief Finds the least valuable piece of the given color in the given
+ * attackers bitboard.
+ *
+ * @param board Board containing the attackers
+ * @param color Color of the attacker to find
+ * @param attackers Bitboard of attacking pieces
+ * @param pieceType Set to the type of the least valuable attacker, if one is found
+ * @return A bitboard containing only the least valuable attacker, or ZERO if
+ * the given color has no attackers
+ */
+U64 _getLeastValuableAttacker(const Board &, Color, U64, PieceType &);
+}
+
+/**
+ * @brief Returns the static exchange evaluation of the given capture on the
+ * given board from the point of view of the player making it.
+ *
+ * Pieces that become attackers as the pieces in front of them capture (x-rays)
+ * are taken into account. Pins are not.
+ *
+ * @param board Board the move is to be made on
+ * @param move Capture, en passant capture or promotion to evaluate
+ * @return The material gained by the given move (negative if it loses material)
+ */
+int evaluate(const Board &, Move);
+};
+
+#endif
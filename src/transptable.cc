@@ -1,24 +1,101 @@
 #include "transptable.h"
-#include <iostream>
+#include <cstring>
+#include <new>
+#include <cstdint>
+
+static_assert(sizeof(TranspTableEntry) == 12, "Transposition table entries must be 12 bytes");
+
+TranspTable::TranspTable(int sizeMb) : _buckets(nullptr), _bucketMask(0), _generation(0) {
+  resize(sizeMb);
+}
+
+void TranspTable::resize(int sizeMb) {
+  // Use the largest power of 2 number of buckets that fits in the given size
+  U64 maxBuckets = (static_cast<U64>(std::max(sizeMb, 1)) << 20) / sizeof(Bucket);
+  U64 numBuckets = 1;
+  while (numBuckets * 2 <= maxBuckets) {
+    numBuckets *= 2;
+  }
+
+  // Fall back to smaller tables if there isn't enough memory for the requested size
+  _memory.reset(nullptr);
+  while (!_memory) {
+    _memory.reset(new(std::nothrow) char[numBuckets * sizeof(Bucket) + CACHE_LINE_SIZE - 1]);
+    if (!_memory && numBuckets > 1) numBuckets /= 2;
+  }
+
+  // Align buckets to the start of a cache line
+  uintptr_t address = reinterpret_cast<uintptr_t>(_memory.get());
+  address = (address + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+  _buckets = reinterpret_cast<Bucket *>(address);
+
+  _bucketMask = numBuckets - 1;
+  clear();
+}
 
 void TranspTable::set(const ZKey &key, TranspTableEntry entry) {
-  auto insertResult = _table.insert(std::make_pair(key.getValue(), entry));
+  Bucket *bucket = _getBucket(key.getValue());
+  uint16_t keyCheck = _keyCheck(key.getValue());
+
+  TranspTableEntry *replace = &bucket->entries[0];
+  int replaceWorth = INF;
+  for (auto &curr : bucket->entries) {
+    // An entry for the same position is kept if it is much deeper than the new
+    // one and from this search, unless the new entry holds an exact score
+    if (curr._depth != 0 && curr._key == keyCheck) {
+      bool currentGeneration = (curr._genFlag & ~TranspTableEntry::FLAG_MASK) == _generation;
+      if (currentGeneration && entry.getFlag() != TranspTableEntry::EXACT
+          && entry._depth + SAME_KEY_DEPTH_MARGIN < curr._depth) {
+        return;
+      }
+
+      // Keep the old best move if the new entry doesn't have one
+      if (entry.getBestMove().getFlags() & Move::NULL_MOVE) {
+        entry._move = curr._move;
+      }
+      replace = &curr;
+      break;
+    }
 
-  // If insertion was prevented due to the key already existing, overwrite the value
-  if (!insertResult.second) {
-    insertResult.first->second = entry;
+    // Always overwrite an empty entry
+    if (curr._depth == 0) {
+      replace = &curr;
+      break;
+    }
+
+    // Otherwise replace the shallowest entry, counting entries from older
+    // searches as being 8 plies shallower for each generation of age
+    int age = ((_generation - (curr._genFlag & ~TranspTableEntry::FLAG_MASK)) & 0xFF) / GENERATION_DELTA;
+    int worth = curr._depth - 8 * age;
+    if (worth < replaceWorth) {
+      replace = &curr;
+      replaceWorth = worth;
+    }
   }
+
+  entry._key = keyCheck;
+  entry._genFlag = _generation | (entry._genFlag & TranspTableEntry::FLAG_MASK);
+  *replace = entry;
 }
 
 void TranspTable::clear() {
-  _table.clear();
+  std::memset(static_cast<void *>(_buckets), 0, (_bucketMask + 1) * sizeof(Bucket));
+  _generation = 0;
+}
+
+void TranspTable::newSearch() {
+  _generation += GENERATION_DELTA;
 }
 
 const TranspTableEntry *TranspTable::getEntry(const ZKey &key) const {
-  auto got = _table.find(key.getValue());
-  if (got != _table.end()) {
-    return &_table.at(key.getValue());
-  } else {
-    return nullptr;
+  const Bucket *bucket = _getBucket(key.getValue());
+  uint16_t keyCheck = _keyCheck(key.getValue());
+
+  for (auto &curr : bucket->entries) {
+    if (curr._key == keyCheck && curr._depth != 0) {
+      return &curr;
+    }
   }
+
+  return nullptr;
 }
@@ -4,7 +4,7 @@
 #include "board.h"
 #include "zkey.h"
 #include "transptableentry.h"
-#include <unordered_map>
+#include <memory>
 
 /**
  * @brief A transposition table.
@@ -12,6 +12,17 @@
  * Each entry is mapped to by a ZKey and contains a score, depth and flag which
  * indicates if the stored score is an upper bound, lower bound or exact score.
  *
+ * The table is a preallocated, cache line aligned array of buckets, each
+ * holding TranspTable::BUCKET_SIZE entries. A ZKey's low bits select its bucket
+ * and its upper 16 bits are stored in the entry to tell positions sharing a
+ * bucket apart. When a bucket is full, the entry with the lowest depth (with
+ * entries from previous searches counting as shallower) is replaced. Shallow
+ * results for a position don't replace a much deeper entry for it.
+ *
+ * A single TranspTable may be shared by several search threads. Accesses are
+ * not synchronized, so a racing write may leave a torn entry behind. Callers
+ * must therefore never trust a best move from the table without checking that
+ * it is legal in the current position.
  */
 class TranspTable {
  public:
@@ -26,14 +37,35 @@ class TranspTable {
   };
 
   /**
-   * @brief Constructs a new empty transposition table.
+   * @brief Default size of a transposition table in megabytes
+   */
+  static const int DEFAULT_SIZE_MB = 16;
+
+  /**
+   * @brief Constructs a new empty transposition table of the given size.
+   *
+   * @param sizeMb Size of the table in megabytes
+   */
+  TranspTable(int= DEFAULT_SIZE_MB);
+
+  /**
+   * @brief Resizes this transposition table to the given size, clearing it.
+   *
+   * If that much memory can't be allocated, the table is made as large as
+   * possible instead.
+   *
+   * @param sizeMb New size of the table in megabytes
    */
-  TranspTable() = default;;
+  void resize(int);
 
   /**
    * @brief Creates a new entry in the transposition table.
    *
-   * If the entry already exists, it will be overwritten.
+   * If an entry for the same key already exists, it will be overwritten,
+   * unless it was stored during the current search at a depth more than
+   * SAME_KEY_DEPTH_MARGIN plies deeper and the new entry is not exact. The
+   * old best move is kept if the new entry has none. Otherwise the least
+   * valuable entry in the key's bucket is replaced.
    *
    * @param key Zobrist key of the board
    * @param entry Entry to store
@@ -54,13 +86,85 @@ class TranspTable {
    */
   void clear();
 
+  /**
+   * @brief Advances the generation of this table.
+   *
+   * This should be called at the start of every search so that entries left
+   * over from previous searches are replaced first.
+   */
+  void newSearch();
+
  private:
   /**
-   * @brief The transposition table hash map.
+   * @brief Size of a cache line in bytes
+   */
+  static const int CACHE_LINE_SIZE = 64;
+
+  /**
+   * @brief Number of entries in each bucket
+   */
+  static const int BUCKET_SIZE = 5;
+
+  /**
+   * @brief Number of plies an entry may be shallower than an entry for the
+   * same position and still replace it
+   */
+  static const int SAME_KEY_DEPTH_MARGIN = 3;
+
+  /**
+   * @brief Amount added to the generation by newSearch()
+   *
+   * The lower 2 bits of TranspTableEntry::_genFlag hold the flag, so the
+   * generation is kept in the upper 6 bits.
+   */
+  static const int GENERATION_DELTA = 4;
+
+  /**
+   * @brief A group of entries that fits into a single cache line.
+   */
+  struct Bucket {
+    TranspTableEntry entries[BUCKET_SIZE];
+    char padding[CACHE_LINE_SIZE - BUCKET_SIZE * sizeof(TranspTableEntry)];
+  };
+  static_assert(sizeof(Bucket) == CACHE_LINE_SIZE, "Transposition table buckets must fill one cache line");
+
+  /**
+   * @brief Memory backing _buckets (over allocated for alignment)
+   */
+  std::unique_ptr<char[]> _memory;
+
+  /**
+   * @brief Cache line aligned array of buckets (points into _memory)
+   */
+  Bucket *_buckets;
+
+  /**
+   * @brief Number of buckets in _buckets minus one, used to map keys to buckets
+   *
+   * The number of buckets is always a power of 2.
+   */
+  U64 _bucketMask;
+
+  /**
+   * @brief Current generation shifted into the upper 6 bits of a byte
+   */
+  uint8_t _generation;
+
+  /**
+   * @brief Returns the upper 16 bits of the given key that are stored in entries.
+   *
+   * @param key Key to get the stored bits of
+   * @return The upper 16 bits of the key
+   */
+  static uint16_t _keyCheck(U64 key) { return static_cast<uint16_t>(key >> 48); }
+
+  /**
+   * @brief Returns the bucket that the given key maps to.
    *
-   * A map of ZKeys to a tuple of (score, depth, flag).
+   * @param key Key to get bucket of
+   * @return The bucket that the given key maps to
    */
-  std::unordered_map<U64, TranspTableEntry> _table;
+  Bucket *_getBucket(U64 key) const { return &_buckets[key & _bucketMask]; }
 };
 
 #endif
@@ -2,11 +2,22 @@
 #define TRANSPTABLEENTRY_H
 
 #include "move.h"
+#include <cstdint>
+#include <algorithm>
+
+class TranspTable;
 
 /**
  * @brief Represents an entry in a transposition table.
  *
- * Stores score, depth, upper/lower bound information and the best move found
+ * Stores score, depth, upper/lower bound information and the best move found.
+ *
+ * Entries are packed into 12 bytes so that 5 of them fit in a single cache
+ * line sized TranspTable bucket. Scores are stored in 16 bits (with +/-INF
+ * saturated to the limits of the 16 bit range), depths in 8 bits and the best
+ * move in its packed 32 bit form. The remaining 16 bits cache the static
+ * evaluation of the position, so that it doesn't need to be recomputed when
+ * the position is reached again.
  */
 class TranspTableEntry {
  public:
@@ -20,59 +31,140 @@ class TranspTableEntry {
     UPPER_BOUND
   };
 
+  /**
+   * @brief Static evaluation stored in entries that don't have one.
+   */
+  static const int NO_EVAL = -32768;
+
+  /**
+   * @brief Construct a new empty transposition table entry.
+   */
+  TranspTableEntry() : _move(0), _key(0), _score(0), _depth(0), _genFlag(0), _eval(NO_EVAL) {}
+
   /**
    * @brief Construct a new transposition table entry with the given score, depth,
-   * type flag and best move.
+   * type flag, best move and static evaluation.
    *
    * @param score Score at node
    * @param depth Depth node was searched to
    * @param flag Type flag for this entry
    * @param bestMove Best move found at this node
+   * @param eval Static evaluation of the node for the side to move, or NO_EVAL
    */
-  TranspTableEntry(int score, int depth, Flag flag, Move bestMove)
-      : _score(score), _depth(depth), _flag(flag), _bestMove(bestMove) {}
+  TranspTableEntry(int score, int depth, Flag flag, Move bestMove, int eval = NO_EVAL)
+      : _move(bestMove.getPacked()),
+        _key(0),
+        _score(_packScore(score)),
+        _depth(_packDepth(depth)),
+        _genFlag(flag),
+        _eval(static_cast<int16_t>(eval)) {}
 
   /**
    * @brief Get the score stored in this transposition table entry.
    *
    * @return The score stored in this transposition table entry
    */
-  int getScore() const { return _score; }
+  int getScore() const { return _unpackScore(_score); }
 
   /**
    * @brief Get the depth of this transposition table entry.
    *
    * @return The depth of this transposition table entry
    */
-  int getDepth() const { return _depth; }
+  int getDepth() const { return _depth - DEPTH_OFFSET; }
 
   /**
    * @brief Get the type flag of this transposition table entry.
    *
    * @return The type flag of this transposition table entry
    */
-  int getFlag() const { return _flag; }
+  int getFlag() const { return _genFlag & FLAG_MASK; }
 
   /**
    * @brief Get the best move of this transposition table entry.
    *
    * @return The best move of this transposition table entry.
    */
-  Move getBestMove() const { return _bestMove; }
+  Move getBestMove() const { return Move(_move); }
+
+  /**
+   * @brief Get the static evaluation stored in this transposition table entry.
+   *
+   * @return The static evaluation of the position for the side to move, or NO_EVAL if none was stored
+   */
+  int getEval() const { return _eval; }
 
  private:
+  friend class TranspTable;
+
+  /**
+   * @brief Added to depths when they are stored so that a stored depth of 0
+   * always marks an empty entry.
+   */
+  static const int DEPTH_OFFSET = 8;
+
+  /**
+   * @brief Largest magnitude of a score that can be stored, scores outside of
+   * [-SCORE_LIMIT, SCORE_LIMIT] are saturated to +/-INF.
+   */
+  static const int SCORE_LIMIT = 32767;
+
+  /**
+   * @brief Mask for the type flag in _genFlag (the rest holds the generation)
+   */
+  static const int FLAG_MASK = 0x3;
+
+  /**
+   * @brief Packs the given score into 16 bits.
+   *
+   * @param score Score to pack
+   * @return The packed score
+   */
+  static int16_t _packScore(int score) {
+    if (score >= SCORE_LIMIT) return SCORE_LIMIT;
+    if (score <= -SCORE_LIMIT) return -SCORE_LIMIT;
+    return static_cast<int16_t>(score);
+  }
+
+  /**
+   * @brief Unpacks the given 16 bit score.
+   *
+   * @param score Score to unpack
+   * @return The unpacked score
+   */
+  static int _unpackScore(int16_t score) {
+    if (score == SCORE_LIMIT) return INF;
+    if (score == -SCORE_LIMIT) return -INF;
+    return score;
+  }
+
+  /**
+   * @brief Packs the given depth into 8 bits.
+   *
+   * @param depth Depth to pack
+   * @return The packed depth
+   */
+  static uint8_t _packDepth(int depth) {
+    return static_cast<uint8_t>(std::max(1, std::min(depth + DEPTH_OFFSET, 255)));
+  }
+
+  /** @brief Packed best move of this transposition table entry */
+  uint32_t _move;
+
+  /** @brief Upper 16 bits of the ZKey of the position stored in this entry */
+  uint16_t _key;
 
   /** @brief Score of this transposition table entry */
-  int _score;
+  int16_t _score;
 
-  /** @brief Depth of this transposition table entry */
-  int _depth;
+  /** @brief Depth of this transposition table entry (offset by DEPTH_OFFSET), 0 if empty */
+  uint8_t _depth;
 
-  /** @brief Type flag of this transposition table entry */
-  Flag _flag;
+  /** @brief Generation this entry was stored in (upper 6 bits) and type flag (lower 2 bits) */
+  uint8_t _genFlag;
 
-  /** @brief Best move of this transposition table entry */
-  Move _bestMove;
+  /** @brief Static evaluation of the position stored in this entry, NO_EVAL if unknown */
+  int16_t _eval;
 };
 
 #endif
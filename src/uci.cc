@@ -9,6 +9,12 @@ Book book;
 std::shared_ptr<Search> search;
 Board board;
 std::vector<ZKey> positionHistory;
+TranspTable tt;
+std::thread searchThread;
+
+void waitForSearch() {
+  if (searchThread.joinable()) searchThread.join();
+}
 
 void loadBook() {
   std::ifstream bookFile(optionsMap["BookPath"].getValue());
@@ -22,20 +28,50 @@ void loadBook() {
   }
 }
 
+void resizeHash() {
+  tt.resize(std::stoi(optionsMap["Hash"].getValue()));
+}
+
+void clearHash() {
+  tt.clear();
+}
+
 void initOptions() {
   optionsMap["OwnBook"] = Option(false);
   optionsMap["BookPath"] = Option("book.bin", &loadBook);
+  optionsMap["Threads"] = Option(1, 1, 256);
+  optionsMap["Hash"] = Option(TranspTable::DEFAULT_SIZE_MB, 1, 65536, &resizeHash);
+  optionsMap["Clear Hash"] = Option(&clearHash);
+  optionsMap["HashMoveFallback"] = Option("IIR");
+}
+
+Search::Settings getSearchSettings() {
+  Search::Settings settings;
+  settings.threads = std::stoi(optionsMap["Threads"].getValue());
+
+  // One of IIR, IID or None, anything else keeps the default
+  std::string fallback = optionsMap["HashMoveFallback"].getValue();
+  if (fallback == "IID") {
+    settings.hashMoveFallback = Search::IID;
+  } else if (fallback == "None") {
+    settings.hashMoveFallback = Search::NO_FALLBACK;
+  }
+  return settings;
 }
 
 void uciNewGame() {
   board.setToStartPos();
   positionHistory.clear();
+  tt.clear();
 }
 
 void setPosition(std::istringstream &is) {
   std::string token;
   is >> token;
 
+  // The position is set up from scratch, so is its history
+  positionHistory.clear();
+
   if (token == "startpos") {
     board.setToStartPos();
   } else {
@@ -54,10 +90,10 @@ void setPosition(std::istringstream &is) {
     }
 
     MoveGen movegen(board);
-    for (auto move : movegen.getMoves()) {
+    for (auto move : movegen.getLegalMoves()) {
       if (move.getNotation() == token) {
-        board.doMove(move);
         positionHistory.push_back(board.getZKey());
+        board.doMove(move);
         break;
       }
     }
@@ -88,13 +124,14 @@ void go(std::istringstream &is) {
     else if (token == "movestogo") is >> limits.movesToGo;
   }
 
-  search = std::make_shared<Search>(board, limits, positionHistory);
+  // The transposition table is shared between searches, so never run two at once
+  waitForSearch();
+  search = std::make_shared<Search>(board, limits, positionHistory, &tt, true, getSearchSettings());
 
-  std::thread searchThread(&pickBestMove);
-  searchThread.detach();
+  searchThread = std::thread(&pickBestMove);
 }
 
-unsigned long long perft(const Board &board, int depth) {
+unsigned long long perft(Board &board, int depth) {
   if (depth <= 0) {
     return 1;
   } else if (depth == 1) {
@@ -105,10 +142,9 @@ unsigned long long perft(const Board &board, int depth) {
 
   unsigned long long nodes = 0;
   for (auto move : movegen.getLegalMoves()) {
-    Board movedBoard = board;
-    movedBoard.doMove(move);
-
-    nodes += perft(movedBoard, depth - 1);
+    board.doMove(move);
+    nodes += perft(board, depth - 1);
+    board.undoMove();
   }
 
   return nodes;
@@ -118,14 +154,14 @@ void perftDivide(int depth) {
   unsigned long long total = 0;
 
   MoveGen movegen(board);
+  Board perftBoard = board;
 
   std::cout << std::endl;
   auto start = std::chrono::steady_clock::now();
   for (auto move : movegen.getLegalMoves()) {
-    Board movedBoard = board;
-    movedBoard.doMove(move);
-
-    unsigned long long perftRes = perft(movedBoard, depth - 1);
+    perftBoard.doMove(move);
+    unsigned long long perftRes = perft(perftBoard, depth - 1);
+    perftBoard.undoMove();
     total += perftRes;
 
     std::cout << move.getNotation() << ": " << perftRes << std::endl;
@@ -139,6 +175,47 @@ void perftDivide(int depth) {
   std::cout << "Nodes / second  : " << static_cast<int>(total / elapsed.count()) << std::endl;
 }
 
+void bench(int depth) {
+  // Positions taken from a mix of opening, middlegame and endgame play
+  const std::string benchFens[] = {
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1QBPPP/R3KB1R w KQ - 0 9",
+      "r2q1rk1/1b1nbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - - 0 12",
+      "2r2rk1/1bqnbppp/p2ppn2/1p6/4P3/1NN1BP2/PPPQB1PP/2KR3R w - - 4 15",
+      "r4rk1/pp1n1ppp/2pbpq2/3p4/2PP4/1PN1PN2/P4PPP/R2Q1RK1 w - - 0 12",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "8/k7/3p4/p2P1p2/P2P1P2/8/8/K7 w - - 0 1",
+      "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1"
+  };
+
+  Search::Limits limits;
+  limits.depth = depth;
+
+  U64 total = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto fen : benchFens) {
+    // Start each position with an empty table so that results are reproducible
+    tt.clear();
+
+    Search benchSearch(Board(fen), limits, std::vector<ZKey>(), &tt, false, getSearchSettings());
+    benchSearch.iterDeep();
+
+    total += benchSearch.getNodes();
+    std::cout << fen << ": " << benchSearch.getNodes() << std::endl;
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = end - start;
+
+  std::cout << std::endl << "==========================" << std::endl;
+  std::cout << "Threads         : " << optionsMap["Threads"].getValue() << std::endl;
+  std::cout << "HashMoveFallback: " << optionsMap["HashMoveFallback"].getValue() << std::endl;
+  std::cout << "Total time (ms) : " << static_cast<int>(elapsed.count() * 1000) << std::endl;
+  std::cout << "Nodes searched  : " << total << std::endl;
+  std::cout << "Nodes / second  : " << static_cast<U64>(total / elapsed.count()) << std::endl;
+}
+
 void printEngineInfo() {
   std::cout << "id name Shallow Blue " << VER_MAJ << "." << VER_MIN << "." << VER_PATCH << std::endl;
   std::cout << "id author Rhys Rustad-Elliott" << std::endl;
@@ -148,7 +225,10 @@ void printEngineInfo() {
     std::cout << "option ";
     std::cout << "name " << optionPair.first << " ";
     std::cout << "type " << optionPair.second.getType() << " ";
-    std::cout << "default " << optionPair.second.getDefaultValue() << " ";
+
+    if (optionPair.second.getType() != "button") {
+      std::cout << "default " << optionPair.second.getDefaultValue() << " ";
+    }
 
     if (optionPair.second.getType() == "spin") {
       std::cout << "min " << optionPair.second.getMin() << " ";
@@ -162,12 +242,23 @@ void printEngineInfo() {
 void setOption(std::istringstream &is) {
   std::string token;
   std::string optionName;
+  std::string value;
+
+  is >> token; // Advance past "name"
+
+  // Option names may contain spaces, read up until "value"
+  while (is >> token && token != "value") {
+    optionName += (optionName.empty() ? "" : " ") + token;
+  }
 
-  is >> token >> optionName; // Advance past "name"
+  while (is >> token) {
+    value += (value.empty() ? "" : " ") + token;
+  }
 
   if (optionsMap.find(optionName) != optionsMap.end()) {
-    is >> token >> token; // Advance past "value"
-    optionsMap[optionName].setValue(token);
+    if (!optionsMap[optionName].setValue(value)) {
+      std::cout << "Invalid option value" << std::endl;
+    }
   } else {
     std::cout << "Invalid option" << std::endl;
   }
@@ -194,6 +285,7 @@ void loop() {
     if (token == "uci") {
       printEngineInfo();
     } else if (token == "ucinewgame") {
+      waitForSearch();
       uciNewGame();
     } else if (token == "isready") {
       std::cout << "readyok" << std::endl;
@@ -203,10 +295,12 @@ void loop() {
       go(is);
     } else if (token == "quit") {
       if (search) search->stop();
+      waitForSearch();
       return;
     } else if (token == "position") {
       setPosition(is);
     } else if (token == "setoption") {
+      waitForSearch();
       setOption(is);
     }
 
@@ -214,7 +308,8 @@ void loop() {
     else if (token == "printboard") {
       std::cout << std::endl << board.getStringRep() << std::endl;
     } else if (token == "printmoves") {
-      for (auto move : MoveGen(board).getLegalMoves()) {
+      MoveGen movegen(board);
+      for (auto move : movegen.getLegalMoves()) {
         std::cout << move.getNotation() << " ";
       }
       std::cout << std::endl;
@@ -222,10 +317,19 @@ void loop() {
       int depth = 1;
       is >> depth;
       perftDivide(depth);
+    } else if (token == "bench") {
+      int depth = 6;
+      is >> depth;
+      waitForSearch();
+      bench(depth);
     } else {
       std::cout << "what?" << std::endl;
     }
   }
+
+  // Input closed without a quit command
+  if (search) search->stop();
+  waitForSearch();
 }
 }
 
@@ -195,4 +195,20 @@ TEST_CASE("Board::doMove works properly") {
 
     REQUIRE(board.getEnPassant() == (ONE << a6));
   }
+
+  SECTION("doMove updates the pawn structure ZKey when pawns are captured or promoted") {
+    board.setToFen("4k3/1P6/8/3p4/8/8/8/3RK3 w - -");
+
+    Move capture(d1, d5, ROOK, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    board.doMove(capture);
+    board.doMove(Move(e8, f7, KING));
+
+    Move promotion(b7, b8, PAWN, Move::PROMOTION);
+    promotion.setPromotionPieceType(QUEEN);
+    board.doMove(promotion);
+
+    Board expected("1Q6/5k2/8/3R4/8/8/8/4K3 b - -");
+    REQUIRE(board.getPawnStructureZKey().getValue() == expected.getPawnStructureZKey().getValue());
+  }
 }
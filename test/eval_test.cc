@@ -17,6 +17,17 @@ TEST_CASE("Evaluation functions work properly") {
     REQUIRE(Eval::evaluate(board, WHITE) == -Eval::evaluate(board, BLACK));
   }
 
+  SECTION("Lazy eval only considers material and piece square tables") {
+    board.setToStartPos();
+    REQUIRE(Eval::evaluateLazy(board, WHITE) == 0);
+
+    // Same piece square table scores, but black is missing its queen
+    board.setToFen("rnb1kbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -");
+    int pstScore = board.getPSquareTable().getScore(OPENING, WHITE) - board.getPSquareTable().getScore(OPENING, BLACK);
+    REQUIRE(Eval::evaluateLazy(board, WHITE) == Eval::getMaterialValue(QUEEN) + pstScore);
+    REQUIRE(Eval::evaluateLazy(board, BLACK) == -Eval::evaluateLazy(board, WHITE));
+  }
+
   SECTION("Doubled pawn calculations are correct") {
     board.setToStartPos();
     REQUIRE(Eval::doubledPawns(board, WHITE) == 0);
@@ -1,23 +1,24 @@
 #include "catch.hpp"
 #include "generalmovepicker.h"
+#include <algorithm>
 
 TEST_CASE("GeneralMovePicker works as expected") {
   Board board;
   TranspTable tt;
   OrderingInfo orderingInfo(const_cast<TranspTable *>(&tt));
+  SearchStack stack[SearchStack::SIZE];
+  SearchStack *ss = &stack[SearchStack::OFFSET];
 
   SECTION("GeneralMovePicker returns the hash move first") {
     board.setToFen("7k/8/8/8/4p3/8/5N2/K7 w - -");
 
-    MoveGen moveGen(board);
-    MoveList moves = moveGen.getLegalMoves();
 
     // Set NxP as the has move
     Move hashMove(f2, e4, KNIGHT, Move::CAPTURE);
     TranspTableEntry ttEntry(20, 2, TranspTableEntry::EXACT, hashMove);
     tt.set(board.getZKey(), ttEntry);
 
-    GeneralMovePicker movePicker(const_cast<OrderingInfo *>(&orderingInfo), const_cast<Board *>(&board), &moves);
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
 
     REQUIRE(movePicker.hasNext());
     REQUIRE(movePicker.getNext() == hashMove);
@@ -26,9 +27,7 @@ TEST_CASE("GeneralMovePicker works as expected") {
   SECTION("GeneralMovePicker returns captures after the hash move in MVV/LVA order") {
     board.setToFen("7k/1R6/1p6/8/4r3/8/5N2/K2b4 w - -");
 
-    MoveGen movegen(board);
-    MoveList moves = movegen.getLegalMoves();
-    GeneralMovePicker movePicker(const_cast<OrderingInfo *>(&orderingInfo), const_cast<Board *>(&board), &moves);
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
 
     // f2 x e4
     Move m1(f2, e4, KNIGHT, Move::CAPTURE);
@@ -52,9 +51,7 @@ TEST_CASE("GeneralMovePicker works as expected") {
   SECTION("GeneralMovePicker returns promotions after captures sorted by promotion value") {
     board.setToFen("7k/2P5/8/8/8/8/8/K7 w - -");
 
-    MoveGen movegen(board);
-    MoveList moves = movegen.getLegalMoves();
-    GeneralMovePicker movePicker(const_cast<OrderingInfo *>(&orderingInfo), const_cast<Board *>(&board), &moves);
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
 
     // Queen promotion
     Move m1(c7, c8, PAWN, Move::PROMOTION);
@@ -84,16 +81,14 @@ TEST_CASE("GeneralMovePicker works as expected") {
   SECTION("GeneralMovePicker returns killer 1 and 2 (in that order) after promotions") {
     board.setToStartPos();
 
-    MoveGen movegen(board);
-    MoveList moves = movegen.getLegalMoves();
 
     Move killer1(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
     Move killer2(f2, f4, PAWN, Move::DOUBLE_PAWN_PUSH);
 
-    orderingInfo.updateKillers(0, killer2);
-    orderingInfo.updateKillers(0, killer1);
+    ss->updateKillers(killer2);
+    ss->updateKillers(killer1);
 
-    GeneralMovePicker movePicker(const_cast<OrderingInfo *>(&orderingInfo), const_cast<Board *>(&board), &moves);
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
 
     REQUIRE(movePicker.hasNext());
     REQUIRE(movePicker.getNext() == killer1);
@@ -102,18 +97,59 @@ TEST_CASE("GeneralMovePicker works as expected") {
     REQUIRE(movePicker.getNext() == killer2);
   }
 
+  SECTION("GeneralMovePicker returns the counter move of the last move before other quiets") {
+    board.setToStartPos();
+    board.doMove(Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH));
+    (ss - 1)->currentMove = Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+
+    Move counterMove(e7, e5, PAWN, Move::DOUBLE_PAWN_PUSH);
+    orderingInfo.updateCounterMove(BLACK, Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH), counterMove);
+
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
+
+    REQUIRE(movePicker.hasNext());
+    REQUIRE(movePicker.getNext() == counterMove);
+
+    // The counter move isn't returned again
+    while (movePicker.hasNext()) {
+      REQUIRE_FALSE(movePicker.getNext() == counterMove);
+    }
+  }
+
+  SECTION("GeneralMovePicker orders captures of the same victim by capture history") {
+    board.setToFen("7k/8/8/3p4/8/2N2B2/8/K7 w - -");
+
+    Move knightCapture(c3, d5, KNIGHT, Move::CAPTURE);
+    knightCapture.setCapturedPieceType(PAWN);
+    Move bishopCapture(f3, d5, BISHOP, Move::CAPTURE);
+    bishopCapture.setCapturedPieceType(PAWN);
+
+    // MVV/LVA prefers the knight capture
+    GeneralMovePicker mvvLvaPicker(&orderingInfo, &board, ss);
+    REQUIRE(mvvLvaPicker.hasNext());
+    REQUIRE(mvvLvaPicker.getNext() == knightCapture);
+
+    for (int i = 0; i < 20; i++) {
+      orderingInfo.incrementCaptureHistory(WHITE, bishopCapture, 10);
+    }
+
+    GeneralMovePicker historyPicker(&orderingInfo, &board, ss);
+    REQUIRE(historyPicker.hasNext());
+    REQUIRE(historyPicker.getNext() == bishopCapture);
+    REQUIRE(historyPicker.hasNext());
+    REQUIRE(historyPicker.getNext() == knightCapture);
+  }
+
   SECTION("GeneralMovePicker returns quiets last sorted by history") {
     board.setToFen("7k/8/8/8/2P5/8/8/K6N w - -");
 
-    MoveGen moveGen(board);
-    MoveList moves = moveGen.getLegalMoves();
 
     // History values h1g3 < h1f2 < c4c5
     orderingInfo.incrementHistory(WHITE, c4, c5, 3);
     orderingInfo.incrementHistory(WHITE, h1, f2, 2);
     orderingInfo.incrementHistory(WHITE, h1, g3, 1);
 
-    GeneralMovePicker movePicker(const_cast<OrderingInfo *>(&orderingInfo), const_cast<Board *>(&board), &moves);
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
 
     REQUIRE(movePicker.hasNext());
     REQUIRE(movePicker.getNext() == Move(c4, c5, PAWN));
@@ -124,4 +160,63 @@ TEST_CASE("GeneralMovePicker works as expected") {
     REQUIRE(movePicker.hasNext());
     REQUIRE(movePicker.getNext() == Move(h1, g3, KNIGHT));
   }
-}
\ No newline at end of file
+
+  SECTION("GeneralMovePicker returns bad captures after quiets") {
+    // Qxd5 loses the queen to the pawn on e6
+    board.setToFen("7k/8/4p3/3p4/8/8/8/K2Q4 w - -");
+
+    Move badCapture(d1, d5, QUEEN, Move::CAPTURE);
+    badCapture.setCapturedPieceType(PAWN);
+
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
+
+    Move lastMove;
+    while (movePicker.hasNext()) {
+      lastMove = movePicker.getNext();
+    }
+
+    REQUIRE(lastMove == badCapture);
+  }
+
+  SECTION("GeneralMovePicker skips hash moves that aren't legal") {
+    board.setToFen("7k/8/8/8/8/8/8/K6N w - -");
+
+    // Hash move from another position
+    Move hashMove(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+    TranspTableEntry ttEntry(20, 2, TranspTableEntry::EXACT, hashMove);
+    tt.set(board.getZKey(), ttEntry);
+
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
+
+    while (movePicker.hasNext()) {
+      REQUIRE_FALSE(movePicker.getNext() == hashMove);
+    }
+  }
+
+  SECTION("GeneralMovePicker returns every legal move exactly once") {
+    board.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+
+    MoveGen movegen(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    // Also has bad captures, such as Qxf6
+    Move hashMove(e5, g6, KNIGHT, Move::CAPTURE);
+    hashMove.setCapturedPieceType(PAWN);
+    TranspTableEntry ttEntry(20, 2, TranspTableEntry::EXACT, hashMove);
+    tt.set(board.getZKey(), ttEntry);
+    ss->updateKillers(Move(a2, a3, PAWN));
+    ss->updateKillers(Move(e1, g1, KING, Move::KSIDE_CASTLE));
+
+    GeneralMovePicker movePicker(&orderingInfo, &board, ss);
+
+    MoveList picked;
+    while (movePicker.hasNext()) {
+      picked.push_back(movePicker.getNext());
+    }
+
+    REQUIRE(picked.size() == legalMoves.size());
+    for (auto move : legalMoves) {
+      REQUIRE(std::count(picked.begin(), picked.end(), move) == 1);
+    }
+  }
+}
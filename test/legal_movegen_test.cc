@@ -0,0 +1,165 @@
+#include "board.h"
+#include "movegen.h"
+#include "catch.hpp"
+#include <algorithm>
+
+bool containsMove(const MoveList &moves, int from, int to) {
+  return std::any_of(moves.begin(), moves.end(), [from, to](Move move) {
+    return (int) move.getFrom() == from && (int) move.getTo() == to;
+  });
+}
+
+TEST_CASE("Legal move generation is correct") {
+  Board board;
+  MoveGen movegen;
+
+  SECTION("Pinned pieces can only move along their pin ray") {
+    // Bishop on e2 pinned by a rook, knight on d2 pinned by a bishop
+    board.setToFen("4r3/8/8/b7/8/8/3NB3/4K3 w - -");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    REQUIRE_FALSE(containsMove(legalMoves, e2, d3));
+    REQUIRE_FALSE(containsMove(legalMoves, d2, b3));
+    REQUIRE_FALSE(containsMove(legalMoves, d2, c4));
+  }
+
+  SECTION("Pinned sliders can capture their pinner") {
+    board.setToFen("4r3/8/8/8/8/8/4R3/4K3 w - -");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    REQUIRE(containsMove(legalMoves, e2, e8));
+    REQUIRE(containsMove(legalMoves, e2, e5));
+    REQUIRE_FALSE(containsMove(legalMoves, e2, d2));
+  }
+
+  SECTION("Single checks must be captured, blocked or evaded") {
+    board.setToFen("4r3/8/8/8/8/8/3B4/R3K3 w - -");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    // Block with the bishop, and king moves off of the e file
+    REQUIRE(containsMove(legalMoves, d2, e3));
+    REQUIRE_FALSE(containsMove(legalMoves, d2, c3));
+    REQUIRE_FALSE(containsMove(legalMoves, a1, a2));
+    REQUIRE(containsMove(legalMoves, e1, f1));
+    REQUIRE_FALSE(containsMove(legalMoves, e1, e2));
+  }
+
+  SECTION("Only the king can move in double check") {
+    board.setToFen("4r3/8/8/8/7b/8/3B4/R3K3 w - -");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    for (auto move : legalMoves) {
+      REQUIRE(move.getPieceType() == KING);
+    }
+    REQUIRE(legalMoves.size() == 2);
+  }
+
+  SECTION("Kings can't step back along the line of a checking slider") {
+    board.setToFen("8/8/8/8/8/8/8/r3K3 w - -");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    REQUIRE_FALSE(containsMove(legalMoves, e1, f1));
+    REQUIRE(containsMove(legalMoves, e1, e2));
+  }
+
+  SECTION("En passant captures can't expose the king along their rank") {
+    board.setToFen("8/8/8/K2Pp2r/8/8/8/7k w - e6");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    REQUIRE_FALSE(containsMove(legalMoves, d5, e6));
+  }
+
+  SECTION("En passant captures can capture a checking pawn") {
+    board.setToFen("8/8/8/3Pp3/3K4/8/8/7k w - e6");
+    movegen.setBoard(board);
+    MoveList legalMoves = movegen.getLegalMoves();
+
+    REQUIRE(containsMove(legalMoves, d5, e6));
+  }
+
+  SECTION("Pseudo-legal moves are still generated on request") {
+    board.setToFen("4r3/8/8/8/8/8/4B3/4K3 w - -");
+    movegen.setBoard(board);
+
+    REQUIRE(containsMove(movegen.getMoves(), e2, d3));
+    REQUIRE_FALSE(containsMove(movegen.getLegalMoves(), e2, d3));
+  }
+
+  SECTION("Captures and quiets together make up all legal moves") {
+    board.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+    movegen.setBoard(board);
+
+    MoveList captures;
+    MoveList quiets;
+    MoveGen::genLegalMoves(board, MoveGen::CAPTURES, captures);
+    MoveGen::genLegalMoves(board, MoveGen::QUIETS, quiets);
+
+    for (auto move : captures) {
+      REQUIRE((move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT)));
+    }
+    for (auto move : quiets) {
+      REQUIRE_FALSE((move.getFlags() & (Move::CAPTURE | Move::PROMOTION | Move::EN_PASSANT)));
+    }
+    REQUIRE(captures.size() + quiets.size() == movegen.getLegalMoves().size());
+  }
+
+  SECTION("Promotions are generated with captures") {
+    board.setToFen("7k/2P5/8/8/8/8/8/K7 w - -");
+
+    MoveList captures;
+    MoveGen::genLegalMoves(board, MoveGen::CAPTURES, captures);
+
+    REQUIRE(captures.size() == 4);
+  }
+
+  SECTION("isLegal accepts legal moves and rejects others") {
+    board.setToFen("4r3/8/8/8/8/8/4B3/4K3 w - -");
+
+    REQUIRE(MoveGen::isLegal(board, Move(e1, d1, KING)));
+    REQUIRE_FALSE(MoveGen::isLegal(board, Move(e2, d3, BISHOP)));
+    REQUIRE_FALSE(MoveGen::isLegal(board, Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH)));
+    REQUIRE_FALSE(MoveGen::isLegal(board, Move()));
+  }
+
+  SECTION("Evasions are all legal moves when in check") {
+    board.setToFen("4r3/8/8/8/8/8/3B4/R3K3 w - -");
+    movegen.setBoard(board);
+
+    MoveList evasions;
+    MoveGen::genLegalMoves(board, MoveGen::EVASIONS, evasions);
+
+    REQUIRE(evasions.size() == movegen.getLegalMoves().size());
+  }
+
+  SECTION("Quiet checks include direct and discovered checks") {
+    board.setToFen("3k4/8/8/8/8/8/3N4/R2RK3 w - -");
+
+    MoveList checks;
+    MoveGen::genLegalMoves(board, MoveGen::QUIET_CHECKS, checks);
+
+    // Any knight move discovers a check from the rook on d1
+    REQUIRE(containsMove(checks, d2, f3));
+    REQUIRE(containsMove(checks, d2, b1));
+    // Direct check along the 8th rank
+    REQUIRE(containsMove(checks, a1, a8));
+    REQUIRE_FALSE(containsMove(checks, a1, a2));
+    REQUIRE_FALSE(containsMove(checks, e1, f1));
+  }
+
+  SECTION("Quiet checks include castling checks") {
+    board.setToFen("5k2/8/8/8/8/8/8/4K2R w K -");
+
+    MoveList checks;
+    MoveGen::genLegalMoves(board, MoveGen::QUIET_CHECKS, checks);
+
+    REQUIRE(containsMove(checks, e1, g1));
+    REQUIRE(containsMove(checks, h1, h8));
+    REQUIRE_FALSE(containsMove(checks, h1, h2));
+  }
+}
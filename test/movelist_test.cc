@@ -0,0 +1,74 @@
+#include "movelist.h"
+#include "catch.hpp"
+
+TEST_CASE("MoveLists work as expected") {
+  MoveList moves;
+
+  SECTION("New MoveLists are empty") {
+    REQUIRE(moves.empty());
+    REQUIRE(moves.size() == 0);
+    REQUIRE(moves.begin() == moves.end());
+  }
+
+  SECTION("Moves can be added and accessed in order") {
+    moves.push_back(Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH));
+    moves.push_back(Move(g1, f3, KNIGHT));
+
+    REQUIRE_FALSE(moves.empty());
+    REQUIRE(moves.size() == 2);
+    REQUIRE(moves.at(0) == Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH));
+    REQUIRE(moves[1] == Move(g1, f3, KNIGHT));
+
+    int count = 0;
+    for (auto move : moves) {
+      REQUIRE(move == moves.at(count++));
+    }
+    REQUIRE(count == 2);
+  }
+
+  SECTION("Moves can be modified in place") {
+    moves.push_back(Move(g1, f3, KNIGHT));
+    for (auto &move : moves) {
+      move.setValue(100);
+    }
+
+    REQUIRE(moves.at(0).getValue() == 100);
+  }
+
+  SECTION("Copies of a MoveList are independent of it") {
+    moves.push_back(Move(g1, f3, KNIGHT));
+
+    MoveList copy = moves;
+    copy.push_back(Move(b1, c3, KNIGHT));
+    copy.at(0).setValue(100);
+
+    REQUIRE(moves.size() == 1);
+    REQUIRE(copy.size() == 2);
+    REQUIRE(moves.at(0).getValue() != 100);
+  }
+
+  SECTION("Cleared MoveLists are empty") {
+    moves.push_back(Move(g1, f3, KNIGHT));
+    moves.clear();
+
+    REQUIRE(moves.empty());
+  }
+
+  SECTION("Resized MoveLists keep their first moves") {
+    moves.push_back(Move(g1, f3, KNIGHT));
+    moves.push_back(Move(b1, c3, KNIGHT));
+    moves.resize(1);
+
+    REQUIRE(moves.size() == 1);
+    REQUIRE(moves.at(0) == Move(g1, f3, KNIGHT));
+  }
+
+  SECTION("MoveLists can hold the maximum number of moves") {
+    size_t maxSize = MoveList::MAX_SIZE;
+    for (size_t i = 0; i < maxSize; i++) {
+      moves.push_back(Move(a1, a2, ROOK));
+    }
+
+    REQUIRE(moves.size() == maxSize);
+  }
+}
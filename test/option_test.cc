@@ -0,0 +1,34 @@
+#include "catch.hpp"
+#include "option.h"
+
+TEST_CASE("Options work as expected") {
+  SECTION("Spin options are clamped to their minimum and maximum") {
+    Option option(16, 1, 1024);
+
+    REQUIRE(option.setValue("64"));
+    REQUIRE(option.getValue() == "64");
+
+    REQUIRE(option.setValue("0"));
+    REQUIRE(option.getValue() == "1");
+
+    REQUIRE(option.setValue("99999999999999999999") == false);
+    REQUIRE(option.setValue("2048"));
+    REQUIRE(option.getValue() == "1024");
+  }
+
+  SECTION("Spin options reject values that aren't numbers") {
+    Option option(16, 1, 1024);
+
+    REQUIRE(option.setValue("foo") == false);
+    REQUIRE(option.setValue("32mb") == false);
+    REQUIRE(option.setValue("") == false);
+    REQUIRE(option.getValue() == "16");
+  }
+
+  SECTION("String options accept any value") {
+    Option option("book.bin");
+
+    REQUIRE(option.setValue("other book.bin"));
+    REQUIRE(option.getValue() == "other book.bin");
+  }
+}
@@ -6,18 +6,6 @@ TEST_CASE("OrderingInfo class works correctly") {
   const TranspTable emptyTt;
   const TranspTable *emptyTtPointer = const_cast<TranspTable *>(&emptyTt);
 
-  SECTION("OrderingInfo stores and adjusts ply information correctly") {
-    OrderingInfo orderingInfo(emptyTtPointer);
-
-    REQUIRE(orderingInfo.getPly() == 0);
-
-    orderingInfo.incrementPly();
-    REQUIRE(orderingInfo.getPly() == 1);
-
-    orderingInfo.deincrementPly();
-    REQUIRE(orderingInfo.getPly() == 0);
-  }
-
   SECTION("OrderingInfo stores transposition table information correctly") {
     TranspTable tt;
     TranspTable *ttPointer = const_cast<TranspTable *>(&tt);
@@ -42,31 +30,6 @@ TEST_CASE("OrderingInfo class works correctly") {
     REQUIRE(orderingInfo.getTt()->getEntry(zkey)->getBestMove() == bestMove);
   }
 
-  SECTION("OrderingInfo stores killer moves correctly") {
-    OrderingInfo orderingInfo(emptyTtPointer);
-
-    // 2 killer moves at ply 1 and 2
-    Move killer1Ply1(a1, a2, ROOK);
-    Move killer2Ply1(h8, h7, ROOK);
-
-    Move killer1Ply2(a2, a3, QUEEN);
-    Move killer2Ply2(h7, h6, QUEEN);
-
-    // Insert killers
-    orderingInfo.updateKillers(1, killer2Ply1);
-    orderingInfo.updateKillers(1, killer1Ply1);
-
-    orderingInfo.updateKillers(2, killer2Ply2);
-    orderingInfo.updateKillers(2, killer1Ply2);
-
-    // Test returned killers
-    REQUIRE(orderingInfo.getKiller1(1) == killer1Ply1);
-    REQUIRE(orderingInfo.getKiller2(1) == killer2Ply1);
-
-    REQUIRE(orderingInfo.getKiller1(2) == killer1Ply2);
-    REQUIRE(orderingInfo.getKiller2(2) == killer2Ply2);
-  }
-
   SECTION("OrderingInfo increments history information correctly") {
     OrderingInfo orderingInfo(emptyTtPointer);
 
@@ -87,5 +50,90 @@ TEST_CASE("OrderingInfo class works correctly") {
 
     REQUIRE(shallowHistory > deepHistory);
   }
-}
 
+  SECTION("OrderingInfo decrements history information correctly") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    orderingInfo.decrementHistory(BLACK, 1, 2, 3);
+    REQUIRE(orderingInfo.getHistory(BLACK, 1, 2) < 0);
+  }
+
+  SECTION("OrderingInfo history values stay bounded") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    int previous = 0;
+    for (int i = 0; i < 1000; i++) {
+      orderingInfo.incrementHistory(WHITE, 1, 2, 20);
+      REQUIRE(orderingInfo.getHistory(WHITE, 1, 2) >= previous);
+      previous = orderingInfo.getHistory(WHITE, 1, 2);
+    }
+    REQUIRE(previous <= 16384);
+
+    for (int i = 0; i < 1000; i++) {
+      orderingInfo.decrementHistory(WHITE, 1, 2, 20);
+    }
+    REQUIRE(orderingInfo.getHistory(WHITE, 1, 2) >= -16384);
+    REQUIRE(orderingInfo.getHistory(WHITE, 1, 2) < 0);
+  }
+
+  SECTION("OrderingInfo stores continuation history by previous move and distance") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    Move previous(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+    Move move(g8, f6, KNIGHT);
+
+    orderingInfo.incrementContinuationHistory(BLACK, 1, previous, move, 4);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 1, previous, move) > 0);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 2, previous, move) == 0);
+
+    orderingInfo.decrementContinuationHistory(BLACK, 2, previous, move, 4);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 2, previous, move) < 0);
+
+    // Null previous moves have no continuation history
+    orderingInfo.incrementContinuationHistory(BLACK, 1, Move(), move, 4);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 1, Move(), move) == 0);
+  }
+
+  SECTION("OrderingInfo stores continuation history separately for each color") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    // The same piece types and squares, once as black replying to white and
+    // once as white replying to black
+    Move previous(e2, e4, PAWN);
+    Move move(g8, f6, KNIGHT);
+
+    orderingInfo.incrementContinuationHistory(BLACK, 1, previous, move, 4);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 1, previous, move) > 0);
+    REQUIRE(orderingInfo.getContinuationHistory(WHITE, 1, previous, move) == 0);
+    REQUIRE(orderingInfo.getContinuationHistory(BLACK, 2, previous, move) == 0);
+  }
+
+  SECTION("OrderingInfo stores capture history by captured piece") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    Move takesPawn(d4, e5, KNIGHT, Move::CAPTURE);
+    takesPawn.setCapturedPieceType(PAWN);
+    Move takesRook(d4, e5, KNIGHT, Move::CAPTURE);
+    takesRook.setCapturedPieceType(ROOK);
+
+    orderingInfo.incrementCaptureHistory(WHITE, takesPawn, 2);
+    orderingInfo.decrementCaptureHistory(WHITE, takesRook, 2);
+
+    REQUIRE(orderingInfo.getCaptureHistory(WHITE, takesPawn) > 0);
+    REQUIRE(orderingInfo.getCaptureHistory(WHITE, takesRook) < 0);
+    REQUIRE(orderingInfo.getCaptureHistory(BLACK, takesPawn) == 0);
+  }
+
+  SECTION("OrderingInfo stores counter moves correctly") {
+    OrderingInfo orderingInfo(emptyTtPointer);
+
+    Move previous(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+    Move counterMove(e7, e5, PAWN, Move::DOUBLE_PAWN_PUSH);
+
+    REQUIRE(orderingInfo.getCounterMove(BLACK, previous) == Move());
+
+    orderingInfo.updateCounterMove(BLACK, previous, counterMove);
+    REQUIRE(orderingInfo.getCounterMove(BLACK, previous) == counterMove);
+    REQUIRE(orderingInfo.getCounterMove(WHITE, previous) == Move());
+  }
+}
@@ -2,7 +2,7 @@
 #include "movegen.h"
 #include "catch.hpp"
 
-unsigned long long perft(int depth, const Board& board) {
+unsigned long long perft(int depth, Board& board) {
   if (depth == 0) {
     return 1;
   } else if (depth == 1) {
@@ -13,10 +13,9 @@ unsigned long long perft(int depth, const Board& board) {
 
   unsigned long long nodes = 0;
   for (auto move : movegen.getLegalMoves()) {
-    Board movedBoard = board;
-    movedBoard.doMove(move);
-
-    nodes += perft(depth - 1, movedBoard);
+    board.doMove(move);
+    nodes += perft(depth - 1, board);
+    board.undoMove();
   }
 
   return nodes;
@@ -7,13 +7,11 @@ TEST_CASE("QSearchMovePicker works as expected") {
 
   SECTION("QSearchMovePicker does not return non captures") {
     board.setToFen("7k/8/5r2/2p5/8/P1R2n2/8/Kb6 w - -");
-    MoveGen moveGen(board);
-    MoveList moves = moveGen.getLegalMoves();
+    QSearchMovePicker movePicker(&board);
 
-    QSearchMovePicker movePicker(&moves);
-
-    // 3 captures for white on the test board
-    for (int i = 0; i < 3; i++) {
+    // 3 captures for white on the test board, but Rxf3 loses the rook to the
+    // rook on f6 and is not returned
+    for (int i = 0; i < 2; i++) {
       REQUIRE(movePicker.hasNext());
       movePicker.getNext();
     }
@@ -24,10 +22,7 @@ TEST_CASE("QSearchMovePicker works as expected") {
 
   SECTION("QSearchMovePicker returns captures sorted by MVV/LVA") {
     board.setToFen("7k/1p5B/4b3/8/3N4/1R3q2/6P1/K7 w - -");
-    MoveGen moveGen(board);
-    MoveList moves = moveGen.getLegalMoves();
-
-    QSearchMovePicker movePicker(&moves);
+    QSearchMovePicker movePicker(&board);
 
     // g2xf3
     REQUIRE(movePicker.hasNext());
@@ -53,13 +48,83 @@ TEST_CASE("QSearchMovePicker works as expected") {
     m4.setCapturedPieceType(BISHOP);
     REQUIRE(movePicker.getNext() == m4);
 
-    // b3xb7
-    REQUIRE(movePicker.hasNext());
-    Move m5(b3, b7, ROOK, Move::CAPTURE);
-    m5.setCapturedPieceType(PAWN);
-    REQUIRE(movePicker.getNext() == m5);
+    // b3xb7 loses the rook to the queen and is not returned
 
     // No more captures
     REQUIRE(!movePicker.hasNext());
   }
-}
\ No newline at end of file
+
+  SECTION("QSearchMovePicker returns en passant captures and promotions") {
+    board.setToFen("7k/2P5/8/3Pp3/8/8/8/K7 w - e6");
+
+    QSearchMovePicker movePicker(&board);
+
+    Move enPassant(d5, e6, PAWN, Move::EN_PASSANT);
+    REQUIRE(movePicker.hasNext());
+    REQUIRE(movePicker.getNext() == enPassant);
+
+    // Queen, rook, bishop and knight promotions
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(movePicker.hasNext());
+      REQUIRE((movePicker.getNext().getFlags() & Move::PROMOTION));
+    }
+
+    REQUIRE(!movePicker.hasNext());
+  }
+
+  SECTION("QSearchMovePicker returns the hash move first, even if it loses material") {
+    board.setToFen("7k/1p5B/4b3/8/3N4/1R3q2/6P1/K7 w - -");
+
+    Move hashMove(b3, b7, ROOK, Move::CAPTURE);
+    hashMove.setCapturedPieceType(PAWN);
+    QSearchMovePicker movePicker(&board, hashMove);
+
+    REQUIRE(movePicker.hasNext());
+    REQUIRE(movePicker.getNext() == hashMove);
+
+    // g2xf3, d4xf3, b3xf3 and d4xe6 follow
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(movePicker.hasNext());
+      movePicker.getNext();
+    }
+
+    REQUIRE(!movePicker.hasNext());
+  }
+
+  SECTION("QSearchMovePicker returns all evasions when in check") {
+    // Black queen checks the white king on a1, which has no captures available
+    board.setToFen("7k/8/8/8/8/8/1q6/K7 w - -");
+    QSearchMovePicker movePicker(&board);
+
+    // Kxb2 is the only legal move
+    Move capture(a1, b2, KING, Move::CAPTURE);
+    capture.setCapturedPieceType(QUEEN);
+    REQUIRE(movePicker.hasNext());
+    REQUIRE(movePicker.getNext() == capture);
+    REQUIRE(!movePicker.hasNext());
+
+    // Quiet evasions are returned too
+    board.setToFen("7k/8/8/8/8/8/8/K6r w - -");
+    QSearchMovePicker evasionPicker(&board);
+
+    int count = 0;
+    while (evasionPicker.hasNext()) {
+      REQUIRE(!(evasionPicker.getNext().getFlags() & Move::CAPTURE));
+      count++;
+    }
+    REQUIRE(count == 2);
+  }
+
+  SECTION("QSearchMovePicker returns quiet checks only if asked to") {
+    board.setToFen("7k/8/8/8/8/8/8/K5R1 w - -");
+
+    QSearchMovePicker noChecks(&board);
+    REQUIRE(!noChecks.hasNext());
+
+    // Rh1+ is returned, while Rg8+ loses the rook to the king and is pruned
+    QSearchMovePicker checks(&board, Move(), true);
+    REQUIRE(checks.hasNext());
+    REQUIRE(checks.getNext() == Move(g1, h1, ROOK));
+    REQUIRE(!checks.hasNext());
+  }
+}
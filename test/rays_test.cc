@@ -8,4 +8,19 @@ TEST_CASE("Ray generation is correct") {
     REQUIRE(Rays::getRay(Rays::NORTH, 0) == 0x0101010101010100ULL);
     REQUIRE(Rays::getRay(Rays::NORTH, 14) == 0x4040404040400000ULL);
   }
+
+  SECTION("Squares between two squares are correct") {
+    REQUIRE(Rays::getBetween(a1, a4) == ((ONE << a2) | (ONE << a3)));
+    REQUIRE(Rays::getBetween(a4, a1) == ((ONE << a2) | (ONE << a3)));
+    REQUIRE(Rays::getBetween(h1, e4) == ((ONE << g2) | (ONE << f3)));
+    REQUIRE(Rays::getBetween(a1, a2) == ZERO);
+    REQUIRE(Rays::getBetween(a1, b3) == ZERO);
+  }
+
+  SECTION("Lines through two squares are correct") {
+    REQUIRE(Rays::getLine(a1, a4) == FILE_A);
+    REQUIRE(Rays::getLine(c1, f1) == RANK_1);
+    REQUIRE(Rays::getLine(b2, g7) == 0x8040201008040201ULL);
+    REQUIRE(Rays::getLine(a1, b3) == ZERO);
+  }
 };
@@ -3,6 +3,7 @@
 
 TEST_CASE("Search works as expected") {
   Board board;
+  TranspTable tt;
   std::vector<ZKey> emptyPositionHistory;
   Search::Limits limits;
   limits.depth = 8;
@@ -10,7 +11,7 @@ TEST_CASE("Search works as expected") {
   SECTION("Search finds the fool's mate checkmakte on the next move") {
     board.setToFen("rnbqkbnr/pppp1ppp/4p3/8/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq -");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "d8h4");
@@ -19,7 +20,7 @@ TEST_CASE("Search works as expected") {
   SECTION("Search returns the only legal move when checkmate is 1 move away") {
     board.setToFen("r4rk1/ppp2ppp/4p3/8/4p3/4PPbP/PPPB2q1/R2QKR2 w - -");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "f1f2");
@@ -28,7 +29,7 @@ TEST_CASE("Search works as expected") {
   SECTION("Search recognizes when a check can be made to capture a queen") {
     board.setToFen("8/4N3/8/1k5q/8/8/8/2K2R2 w - -");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "f1f5");
@@ -37,28 +38,48 @@ TEST_CASE("Search works as expected") {
   SECTION("Search finds a checkmate on the next move") {
     board.setToFen("2kr3r/pp4pp/4N3/q7/2K5/8/PR1b2PP/8 b - - 7 33");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "a5d5");
   }
 
+  SECTION("Search scores checkmates by their distance from the root") {
+    board.setToFen("2kr3r/pp4pp/4N3/q7/2K5/8/PR1b2PP/8 b - - 7 33");
+
+    Search search(board, limits, emptyPositionHistory, &tt, false);
+    search.iterDeep();
+
+    REQUIRE(search.getBestScore() == MATE - 1);
+  }
+
+  SECTION("Search scores getting checkmated by its distance from the root") {
+    board.setToFen("r4rk1/ppp2ppp/4p3/8/4p3/4PPbP/PPPB2q1/R2QKR2 w - -");
+
+    Search search(board, limits, emptyPositionHistory, &tt, false);
+    search.iterDeep();
+
+    REQUIRE(search.getBestScore() == -MATE + 2);
+  }
+
   SECTION("Bratko-Kopec test #1 is correct") {
     board.setToFen("1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - -");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "d6d1");
   }
 
   SECTION("Search recognizes when a repetition draw is the best option") {
+    // Rd1+ Ka2 was just played, so Rd2+ Kb1 repeats the position
     std::vector<ZKey> moveHistory;
-    moveHistory.push_back(Board("6Q1/pp6/8/8/1kp2N2/1n2R1P1/3r4/1K6 b - -").getZKey());
+    moveHistory.push_back(Board("6Q1/pp6/8/8/1kp2N2/1n2R1P1/3r4/1K6 b - - 0 1").getZKey());
+    moveHistory.push_back(Board("6Q1/pp6/8/8/1kp2N2/1n2R1P1/8/1K1r4 w - - 1 2").getZKey());
 
-    board.setToFen("6Q1/pp6/8/8/1kp2N2/1n2R1P1/K7/3r4 b - -");
+    board.setToFen("6Q1/pp6/8/8/1kp2N2/1n2R1P1/K7/3r4 b - - 2 2");
 
-    Search search(board, limits, moveHistory, false);
+    Search search(board, limits, moveHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "d1d2");
@@ -67,9 +88,22 @@ TEST_CASE("Search works as expected") {
   SECTION("Search recognizes when a 50 move rule draw is the best option") {
     board.setToFen("B6k/1r6/8/8/7q/8/PP6/K7 w - - 49");
 
-    Search search(board, limits, emptyPositionHistory, false);
+    Search search(board, limits, emptyPositionHistory, &tt, false);
     search.iterDeep();
 
     REQUIRE(search.getBestMove().getNotation() == "a1b1");
   }
+
+  SECTION("Search reuses transposition table entries from previous searches") {
+    board.setToFen("1k1r4/pp1b1R2/3q2pp/4p3/2B5/4Q3/PPP2B2/2K5 b - -");
+
+    Search firstSearch(board, limits, emptyPositionHistory, &tt, false);
+    firstSearch.iterDeep();
+
+    Search secondSearch(board, limits, emptyPositionHistory, &tt, false);
+    secondSearch.iterDeep();
+
+    REQUIRE(secondSearch.getBestMove() == firstSearch.getBestMove());
+    REQUIRE(secondSearch.getNodes() < firstSearch.getNodes());
+  }
 }
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "searchstack.h"
+
+TEST_CASE("SearchStack works as expected") {
+  SearchStack ss;
+
+  SECTION("New SearchStack entries are empty") {
+    int noEval = TranspTableEntry::NO_EVAL;
+    REQUIRE(ss.staticEval == noEval);
+    REQUIRE(ss.currentMove == Move());
+    REQUIRE(ss.excludedMove == Move());
+    REQUIRE(ss.killer1 == Move());
+    REQUIRE(ss.killer2 == Move());
+    REQUIRE(ss.getContinuationHistory(1, Move(g1, f3, KNIGHT)) == 0);
+  }
+
+  SECTION("SearchStack stores killer moves correctly") {
+    Move killer1(a1, a2, ROOK);
+    Move killer2(h8, h7, ROOK);
+
+    ss.updateKillers(killer2);
+    ss.updateKillers(killer1);
+
+    REQUIRE(ss.killer1 == killer1);
+    REQUIRE(ss.killer2 == killer2);
+
+    // A killer causing another cutoff doesn't push out the other killer
+    ss.updateKillers(killer1);
+
+    REQUIRE(ss.killer1 == killer1);
+    REQUIRE(ss.killer2 == killer2);
+  }
+
+  SECTION("SearchStack looks up continuation history of the current move") {
+    TranspTable tt;
+    OrderingInfo orderingInfo(&tt);
+
+    Move previous(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+    Move reply(g8, f6, KNIGHT);
+    orderingInfo.incrementContinuationHistory(BLACK, 1, previous, reply, 3);
+
+    ss.currentMove = previous;
+    ss.continuationHistory = orderingInfo.getContinuationHistoryTable(WHITE, previous);
+
+    REQUIRE(ss.getContinuationHistory(1, reply) == orderingInfo.getContinuationHistory(BLACK, 1, previous, reply));
+    REQUIRE(ss.getContinuationHistory(1, reply) > 0);
+    REQUIRE(ss.getContinuationHistory(2, reply) == 0);
+
+    // Null moves have no continuation history
+    REQUIRE(orderingInfo.getContinuationHistoryTable(WHITE, Move()) == nullptr);
+  }
+}
@@ -0,0 +1,59 @@
+#include "catch.hpp"
+#include "see.h"
+#include "eval.h"
+
+TEST_CASE("Static exchange evaluation is correct") {
+  Board board;
+
+  int pawn = Eval::getMaterialValue(PAWN);
+  int knight = Eval::getMaterialValue(KNIGHT);
+  int queen = Eval::getMaterialValue(QUEEN);
+
+  SECTION("Undefended pieces are won outright") {
+    board.setToFen("1k6/8/8/3p4/8/8/8/3R2K1 w - -");
+
+    Move capture(d1, d5, ROOK, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    REQUIRE(See::evaluate(board, capture) == pawn);
+  }
+
+  SECTION("Captures of defended pieces lose the capturing piece") {
+    board.setToFen("1k6/8/4p3/3p4/8/8/8/3Q2K1 w - -");
+
+    Move capture(d1, d5, QUEEN, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    REQUIRE(See::evaluate(board, capture) == pawn - queen);
+  }
+
+  SECTION("Sliders behind the capturing piece are taken into account (x-rays)") {
+    // RxP RxR RxR, without the rook on d1 the first capture would lose the rook
+    board.setToFen("1k1r4/8/8/3p4/8/8/3R4/3R2K1 w - -");
+
+    Move capture(d2, d5, ROOK, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    REQUIRE(See::evaluate(board, capture) == pawn);
+  }
+
+  SECTION("Sides may stop recapturing when it would lose material") {
+    // NxN, and black should not recapture with the queen on d8 into the rook on d1
+    board.setToFen("1k1q4/8/8/3n4/8/4N3/8/3R2K1 w - -");
+
+    Move capture(e3, d5, KNIGHT, Move::CAPTURE);
+    capture.setCapturedPieceType(KNIGHT);
+    REQUIRE(See::evaluate(board, capture) == knight);
+  }
+
+  SECTION("Kings can't recapture onto defended squares") {
+    board.setToFen("8/8/8/8/8/2k5/3p4/2BQ2K1 w - -");
+
+    Move capture(d1, d2, QUEEN, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    REQUIRE(See::evaluate(board, capture) == pawn);
+  }
+
+  SECTION("En passant captures are evaluated") {
+    board.setToFen("1k6/8/8/3Pp3/8/8/8/6K1 w - e6");
+
+    REQUIRE(See::evaluate(board, Move(d5, e6, PAWN, Move::EN_PASSANT)) == pawn);
+  }
+}
@@ -1,10 +1,12 @@
 #define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #include "catch.hpp"
 #include "uci.h"
 #include "attacks.h"
 #include "movepicker.h"
 #include "eval.h"
 #include "rays.h"
+#include "search.h"
 
 int main(int argc, char *argv[]) {
   Rays::init();
@@ -13,6 +15,7 @@ int main(int argc, char *argv[]) {
   MovePicker::init();
   Attacks::init();
   Eval::init();
+  Search::init();
   Uci::init();
 
   int result = Catch::Session().run(argc, argv);
@@ -1,4 +1,5 @@
 #include "catch.hpp"
+#include "board.h"
 #include "transptableentry.h"
 
 TEST_CASE("Transposition table entries work as expected") {
@@ -15,4 +16,36 @@ TEST_CASE("Transposition table entries work as expected") {
     REQUIRE(ttEntry.getFlag() == TranspTableEntry::EXACT);
     REQUIRE(ttEntry.getBestMove() == move);
   }
+
+  SECTION("Transposition table entries preserve infinite scores") {
+    Move move(a2, a3, PAWN);
+    TranspTableEntry winEntry(INF, 3, TranspTableEntry::LOWER_BOUND, move);
+    TranspTableEntry lossEntry(-INF, 3, TranspTableEntry::UPPER_BOUND, move);
+
+    REQUIRE(winEntry.getScore() == INF);
+    REQUIRE(lossEntry.getScore() == -INF);
+  }
+
+  SECTION("Transposition table entries store full move information") {
+    Move move(b7, c8, PAWN, Move::CAPTURE | Move::PROMOTION);
+    move.setCapturedPieceType(ROOK);
+    move.setPromotionPieceType(QUEEN);
+    TranspTableEntry ttEntry(-250, 0, TranspTableEntry::UPPER_BOUND, move);
+
+    REQUIRE(ttEntry.getScore() == -250);
+    REQUIRE(ttEntry.getDepth() == 0);
+    REQUIRE(ttEntry.getBestMove() == move);
+    REQUIRE(ttEntry.getBestMove().getCapturedPieceType() == ROOK);
+    REQUIRE(ttEntry.getBestMove().getPromotionPieceType() == QUEEN);
+  }
+
+  SECTION("Transposition table entries store static evaluations") {
+    Move move(a2, a3, PAWN);
+    TranspTableEntry evalEntry(10, 0, TranspTableEntry::LOWER_BOUND, move, -35);
+    TranspTableEntry noEvalEntry(10, 0, TranspTableEntry::LOWER_BOUND, move);
+
+    int noEval = TranspTableEntry::NO_EVAL;
+    REQUIRE(evalEntry.getEval() == -35);
+    REQUIRE(noEvalEntry.getEval() == noEval);
+  }
 }
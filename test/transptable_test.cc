@@ -53,4 +53,53 @@ TEST_CASE("Transposition tables work as expected") {
     tt.clear();
     REQUIRE(tt.getEntry(board.getZKey()) == nullptr);
   }
+
+  SECTION("Transposition tables keep entries from previous searches") {
+    board.setToStartPos();
+
+    Move move(a1, a2, PAWN);
+    TranspTableEntry ttEntry(5, 5, TranspTableEntry::EXACT, move);
+    tt.set(board.getZKey(), ttEntry);
+
+    tt.newSearch();
+    REQUIRE(tt.getEntry(board.getZKey()) != nullptr);
+    REQUIRE(tt.getEntry(board.getZKey())->getScore() == 5);
+  }
+
+  SECTION("Transposition tables keep deeper entries for the same position") {
+    board.setToStartPos();
+
+    Move move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH);
+    tt.set(board.getZKey(), TranspTableEntry(5, 10, TranspTableEntry::LOWER_BOUND, move));
+
+    // A shallow bound doesn't replace the deeper entry
+    tt.set(board.getZKey(), TranspTableEntry(7, 0, TranspTableEntry::UPPER_BOUND, Move()));
+    REQUIRE(tt.getEntry(board.getZKey())->getDepth() == 10);
+    REQUIRE(tt.getEntry(board.getZKey())->getScore() == 5);
+
+    // A bound that is not much shallower does, keeping the old best move
+    tt.set(board.getZKey(), TranspTableEntry(9, 8, TranspTableEntry::UPPER_BOUND, Move()));
+    REQUIRE(tt.getEntry(board.getZKey())->getDepth() == 8);
+    REQUIRE(tt.getEntry(board.getZKey())->getBestMove() == move);
+
+    // Exact scores and entries from later searches always replace older ones
+    tt.set(board.getZKey(), TranspTableEntry(11, 0, TranspTableEntry::EXACT, Move()));
+    REQUIRE(tt.getEntry(board.getZKey())->getScore() == 11);
+
+    tt.set(board.getZKey(), TranspTableEntry(13, 10, TranspTableEntry::EXACT, move));
+    tt.newSearch();
+    tt.set(board.getZKey(), TranspTableEntry(15, 0, TranspTableEntry::UPPER_BOUND, Move()));
+    REQUIRE(tt.getEntry(board.getZKey())->getScore() == 15);
+  }
+
+  SECTION("Transposition tables are cleared when resized") {
+    board.setToStartPos();
+
+    Move move(a1, a2, PAWN);
+    TranspTableEntry ttEntry(5, 5, TranspTableEntry::EXACT, move);
+    tt.set(board.getZKey(), ttEntry);
+
+    tt.resize(1);
+    REQUIRE(tt.getEntry(board.getZKey()) == nullptr);
+  }
 }
@@ -0,0 +1,103 @@
+#include "board.h"
+#include "movegen.h"
+#include "catch.hpp"
+
+void requireBoardsEqual(const Board &board1, const Board &board2) {
+  for (auto color : {WHITE, BLACK}) {
+    for (auto pieceType : {PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING}) {
+      REQUIRE(board1.getPieces(color, pieceType) == board2.getPieces(color, pieceType));
+    }
+    REQUIRE(board1.getAllPieces(color) == board2.getAllPieces(color));
+  }
+
+  REQUIRE(board1.getActivePlayer() == board2.getActivePlayer());
+  REQUIRE(board1.getEnPassant() == board2.getEnPassant());
+  REQUIRE(board1.getHalfmoveClock() == board2.getHalfmoveClock());
+  REQUIRE(board1.whiteCanCastleKs() == board2.whiteCanCastleKs());
+  REQUIRE(board1.whiteCanCastleQs() == board2.whiteCanCastleQs());
+  REQUIRE(board1.blackCanCastleKs() == board2.blackCanCastleKs());
+  REQUIRE(board1.blackCanCastleQs() == board2.blackCanCastleQs());
+  REQUIRE(board1.getZKey().getValue() == board2.getZKey().getValue());
+  REQUIRE(board1.getPawnStructureZKey().getValue() == board2.getPawnStructureZKey().getValue());
+}
+
+void requireUndoRestoresAllMoves(const std::string &fen) {
+  Board board(fen);
+  Board original(fen);
+
+  MoveList legalMoves = MoveGen(board).getLegalMoves();
+  for (auto move : legalMoves) {
+    board.doMove(move);
+
+    // Also undo a reply, so that the state stack is more than one move deep
+    MoveList replies = MoveGen(board).getLegalMoves();
+    if (!replies.empty()) {
+      Board afterMove = board;
+      board.doMove(replies.at(0));
+      board.undoMove();
+      requireBoardsEqual(board, afterMove);
+    }
+
+    board.undoMove();
+    requireBoardsEqual(board, original);
+  }
+}
+
+TEST_CASE("Board::undoMove works properly") {
+  SECTION("undoMove restores the starting position") {
+    requireUndoRestoresAllMoves("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  }
+
+  SECTION("undoMove handles castling and captures") {
+    requireUndoRestoresAllMoves("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  }
+
+  SECTION("undoMove handles en passant") {
+    requireUndoRestoresAllMoves("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+  }
+
+  SECTION("undoMove handles promotions and capture promotions") {
+    requireUndoRestoresAllMoves("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1");
+  }
+
+  SECTION("undoMove restores the halfmove clock") {
+    requireUndoRestoresAllMoves("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 37 60");
+  }
+
+  SECTION("Moves can be undone in sequence") {
+    Board board;
+    board.setToStartPos();
+    Board original = board;
+
+    board.doMove(Move(e2, e4, PAWN, Move::DOUBLE_PAWN_PUSH));
+    Board afterE4 = board;
+    board.doMove(Move(d7, d5, PAWN, Move::DOUBLE_PAWN_PUSH));
+
+    Move capture(e4, d5, PAWN, Move::CAPTURE);
+    capture.setCapturedPieceType(PAWN);
+    board.doMove(capture);
+
+    board.undoMove();
+    board.undoMove();
+    requireBoardsEqual(board, afterE4);
+
+    board.undoMove();
+    requireBoardsEqual(board, original);
+  }
+
+  SECTION("Null moves pass the turn and can be undone") {
+    Board board("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+    Board original = board;
+
+    board.doNullMove();
+
+    // Same position with black to move and no en passant square
+    Board passed("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR b KQkq - 1 3");
+    REQUIRE(board.getActivePlayer() == BLACK);
+    REQUIRE(board.getEnPassant() == ZERO);
+    REQUIRE(board.getZKey().getValue() == passed.getZKey().getValue());
+
+    board.undoMove();
+    requireBoardsEqual(board, original);
+  }
+}